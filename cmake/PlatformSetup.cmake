@@ -43,7 +43,7 @@ function(setup_platform_libs)
         
     elseif(WIN32)
         # Windows libraries
-        set(PLATFORM_LIBS winmm ole32 user32 shell32 gdi32 PARENT_SCOPE)
+        set(PLATFORM_LIBS winmm ole32 user32 shell32 gdi32 psapi PARENT_SCOPE)
         
         # Check for Vulkan SDK
         if(DEFINED ENV{VULKAN_SDK})
@@ -3,6 +3,7 @@
 #include "miniaudio.h"
 #include "utils.h"
 #include "logging.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,75 +12,467 @@
 #define WHISPER_SAMPLE_RATE 16000
 #define WHISPER_CHANNELS 1
 
+// Capture ring between the audio callback and the drain thread. Only needs to cover
+// scheduling hiccups of the drain thread, the full recording lives in buffer.
+#define CAPTURE_RING_SECONDS 4
+#define DRAIN_INTERVAL_MS 20
+
+// Recording buffer size kept between recordings, a longer one is released when the next starts
+#define INITIAL_BUFFER_SAMPLES (WHISPER_SAMPLE_RATE * WHISPER_CHANNELS * 10)
+
+// Upper bound for the always-on pre-roll history
+#define MAX_PREROLL_MS 10000
+
+// Virtual microphone period, the custom backend delivers 10 ms per read
+#define VIRTUAL_MIC_PERIOD_FRAMES (WHISPER_SAMPLE_RATE / 100)
+#define VIRTUAL_MIC_MAX_SPEED 100.0 // The drain thread keeps up with a 4 s ring every 20 ms
+
 // Audio recorder structure
 typedef struct {
+    ma_context context; // Only initialized for the virtual microphone
+    bool has_context;
     ma_device device;
     ma_encoder encoder;
 
-    // Buffer recording
+    // Lock-free SPSC ring: audio callback produces, drain thread consumes.
+    // Preallocated in audio_recorder_init so the callback never allocates.
+    ma_pcm_rb capture_rb;
+    ma_uint64 dropped_frames; // Written by audio thread only, read after the device is stopped
+
+    // Buffer recording - only touched by consumers holding buffer_mutex
     float *buffer;
     size_t buffer_size;
     size_t buffer_capacity;
-    size_t write_position;
+    size_t buffer_peak_capacity;
+    size_t sample_copies_bytes; // Live audio_recorder_get_samples results, also guarded by buffer_mutex
+    size_t sample_copies_peak_bytes;
+    bool capturing; // Drained frames go to buffer when set, to the pre-roll history otherwise
+    utils_mutex_t *buffer_mutex;
+    utils_thread_t *drain_thread;
+
+    // Pre-roll history (circular), filled by the drain thread while monitoring
+    float *preroll;
+    size_t preroll_capacity;
+    size_t preroll_pos;
+    size_t preroll_filled;
 
     // State - accessed from both audio and main threads
     bool is_recording;      // Atomic access required
     bool is_file_recording; // Atomic access required
+    bool is_monitoring;     // Atomic access required - device kept running for pre-roll
+    bool drain_running;     // Atomic access required
     char *filename;
 
     // Timing
     ma_uint64 start_time;
-    ma_uint64 total_frames; // Written by audio thread, read by main thread
+    ma_uint64 total_frames;   // Written by audio thread, read by main thread
+    double first_frame_time;  // Written by audio thread before first_frame_pending is set
+    bool first_frame_pending; // Atomic access required - first_frame_time still needs tracing
 } AudioRecorder;
 
 // Global singleton instance
 static AudioRecorder *g_recorder = NULL;
 
+// Virtual microphone, configured before audio_recorder_init
+typedef struct {
+    bool enabled;
+    ma_decoder decoder; // Converts the file to 16 kHz mono float
+    double speed;
+    bool rewind;   // Atomic access required
+    bool finished; // Atomic access required
+    // Pacing, audio thread only
+    double started_at;
+    ma_uint64 frames_delivered;
+} VirtualMic;
+
+static VirtualMic g_virtual_mic = {0};
+
+// Push captured frames into the ring. Runs on the real-time audio thread: no locks, no allocations.
+// If the drain thread falls behind by more than the ring size, the overflow is dropped and counted.
+static void capture_rb_write(AudioRecorder *recorder, const float *input, ma_uint32 frame_count) {
+    while (frame_count > 0) {
+        ma_uint32 frames = frame_count;
+        void *dst = NULL;
+        if (ma_pcm_rb_acquire_write(&recorder->capture_rb, &frames, &dst) != MA_SUCCESS || frames == 0) {
+            break;
+        }
+        memcpy(dst, input, frames * WHISPER_CHANNELS * sizeof(float));
+        ma_pcm_rb_commit_write(&recorder->capture_rb, frames);
+
+        input += frames * WHISPER_CHANNELS;
+        frame_count -= frames;
+    }
+    recorder->dropped_frames += frame_count;
+}
+
+// Grow the recording buffer. Runs on the consumer side only, never on the audio thread.
+static bool ensure_buffer_capacity(AudioRecorder *recorder, size_t needed) {
+    if (needed <= recorder->buffer_capacity) {
+        return true;
+    }
+
+    size_t new_capacity = recorder->buffer_capacity * 2;
+    if (new_capacity < needed) {
+        new_capacity = needed + 16384;
+    }
+
+    float *new_buffer = (float *) realloc(recorder->buffer, new_capacity * sizeof(float));
+    if (!new_buffer) {
+        return false;
+    }
+    recorder->buffer = new_buffer;
+    recorder->buffer_capacity = new_capacity;
+    if (new_capacity > recorder->buffer_peak_capacity) {
+        recorder->buffer_peak_capacity = new_capacity;
+    }
+    return true;
+}
+
+// Empty the recording buffer for a new recording and give back what a long one made it grow by.
+// Caller holds buffer_mutex.
+static void reset_buffer(AudioRecorder *recorder) {
+    recorder->buffer_size = 0;
+    if (recorder->buffer_capacity <= INITIAL_BUFFER_SAMPLES) {
+        return;
+    }
+    float *new_buffer = (float *) realloc(recorder->buffer, INITIAL_BUFFER_SAMPLES * sizeof(float));
+    if (new_buffer) {
+        recorder->buffer = new_buffer;
+        recorder->buffer_capacity = INITIAL_BUFFER_SAMPLES;
+    }
+}
+
+// Append samples to the circular pre-roll history, keeping only the most recent ones
+static void preroll_push(AudioRecorder *recorder, const float *samples, size_t count) {
+    size_t capacity = recorder->preroll_capacity;
+    if (capacity == 0) {
+        return;
+    }
+
+    if (count > capacity) {
+        samples += count - capacity;
+        count = capacity;
+    }
+
+    size_t first = capacity - recorder->preroll_pos;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(recorder->preroll + recorder->preroll_pos, samples, first * sizeof(float));
+    memcpy(recorder->preroll, samples + first, (count - first) * sizeof(float));
+
+    recorder->preroll_pos = (recorder->preroll_pos + count) % capacity;
+    recorder->preroll_filled += count;
+    if (recorder->preroll_filled > capacity) {
+        recorder->preroll_filled = capacity;
+    }
+}
+
+// Copy the pre-roll history (oldest first) to the start of the recording buffer
+static void preroll_flush_to_buffer(AudioRecorder *recorder) {
+    size_t count = recorder->preroll_filled;
+    if (count == 0 || !ensure_buffer_capacity(recorder, count)) {
+        return;
+    }
+
+    size_t start = (recorder->preroll_pos + recorder->preroll_capacity - count) % recorder->preroll_capacity;
+    size_t first = recorder->preroll_capacity - start;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(recorder->buffer, recorder->preroll + start, first * sizeof(float));
+    memcpy(recorder->buffer + first, recorder->preroll, (count - first) * sizeof(float));
+
+    recorder->buffer_size = count;
+    recorder->preroll_filled = 0;
+}
+
+// Move everything currently in the ring into the recording buffer (or the pre-roll history when idle).
+// Caller must hold buffer_mutex, which also serializes the consumer side of the ring.
+static void capture_rb_drain(AudioRecorder *recorder) {
+    for (;;) {
+        ma_uint32 frames = ma_pcm_rb_available_read(&recorder->capture_rb);
+        if (frames == 0) {
+            break;
+        }
+
+        void *src = NULL;
+        if (ma_pcm_rb_acquire_read(&recorder->capture_rb, &frames, &src) != MA_SUCCESS || frames == 0) {
+            break;
+        }
+
+        size_t samples = (size_t) frames * WHISPER_CHANNELS;
+        if (!recorder->capturing) {
+            preroll_push(recorder, (const float *) src, samples);
+        } else if (ensure_buffer_capacity(recorder, recorder->buffer_size + samples)) {
+            memcpy(recorder->buffer + recorder->buffer_size, src, samples * sizeof(float));
+            recorder->buffer_size += samples;
+        } else {
+            log_error("Failed to grow audio buffer, dropping %u frames", frames);
+        }
+        ma_pcm_rb_commit_read(&recorder->capture_rb, frames);
+    }
+}
+
+// Emit the trace event for the first captured frame. The audio thread only records the time,
+// tracing allocates and locks.
+static void trace_first_frame(AudioRecorder *recorder) {
+    if (utils_atomic_read_bool(&recorder->first_frame_pending)) {
+        utils_atomic_write_bool(&recorder->first_frame_pending, false);
+        trace_instant("first captured frame", recorder->first_frame_time);
+    }
+}
+
+// Consumer thread: keeps the ring empty while the device is running
+static void *drain_thread_proc(void *arg) {
+    AudioRecorder *recorder = (AudioRecorder *) arg;
+
+    while (utils_atomic_read_bool(&recorder->drain_running)) {
+        utils_mutex_lock(recorder->buffer_mutex);
+        capture_rb_drain(recorder);
+        utils_mutex_unlock(recorder->buffer_mutex);
+        trace_first_frame(recorder);
+
+        utils_sleep_ms(DRAIN_INTERVAL_MS);
+    }
+    trace_thread_exit(); // A new drain thread starts with every recording
+    return NULL;
+}
+
+static ma_result virtual_mic_enumerate_devices(ma_context *context, ma_enum_devices_callback_proc callback,
+                                               void *user_data) {
+    ma_device_info info;
+    memset(&info, 0, sizeof(info));
+    ma_strncpy_s(info.name, sizeof(info.name), "Virtual microphone", (size_t) -1);
+    info.isDefault = MA_TRUE;
+    callback(context, ma_device_type_capture, &info, user_data);
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_get_device_info(ma_context *context, ma_device_type device_type,
+                                             const ma_device_id *device_id, ma_device_info *info) {
+    (void) context;
+    (void) device_id;
+    if (device_type != ma_device_type_capture) {
+        return MA_NO_DEVICE;
+    }
+
+    memset(info, 0, sizeof(*info));
+    ma_strncpy_s(info->name, sizeof(info->name), "Virtual microphone", (size_t) -1);
+    info->isDefault = MA_TRUE;
+    info->nativeDataFormats[0].format = ma_format_f32;
+    info->nativeDataFormats[0].channels = WHISPER_CHANNELS;
+    info->nativeDataFormats[0].sampleRate = WHISPER_SAMPLE_RATE;
+    info->nativeDataFormatCount = 1;
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_device_init(ma_device *device, const ma_device_config *config,
+                                         ma_device_descriptor *playback, ma_device_descriptor *capture) {
+    (void) device;
+    (void) playback;
+    if (config->deviceType != ma_device_type_capture) {
+        return MA_DEVICE_TYPE_NOT_SUPPORTED;
+    }
+
+    capture->format = ma_format_f32;
+    capture->channels = WHISPER_CHANNELS;
+    capture->sampleRate = WHISPER_SAMPLE_RATE;
+    capture->channelMap[0] = MA_CHANNEL_MONO;
+    capture->periodSizeInFrames = VIRTUAL_MIC_PERIOD_FRAMES;
+    capture->periodCount = 1;
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_device_uninit(ma_device *device) {
+    (void) device;
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_device_start(ma_device *device) {
+    (void) device;
+    g_virtual_mic.started_at = utils_now();
+    g_virtual_mic.frames_delivered = 0;
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_device_stop(ma_device *device) {
+    (void) device;
+    return MA_SUCCESS;
+}
+
+// Blocking read on the audio thread: the next frames of the file, paced to the configured speed
+static ma_result virtual_mic_device_read(ma_device *device, void *frames, ma_uint32 frame_count,
+                                         ma_uint32 *frames_read) {
+    (void) device;
+    VirtualMic *mic = &g_virtual_mic;
+
+    if (utils_atomic_read_bool(&mic->rewind)) {
+        ma_decoder_seek_to_pcm_frame(&mic->decoder, 0);
+        utils_atomic_write_bool(&mic->finished, false);
+        utils_atomic_write_bool(&mic->rewind, false);
+    }
+
+    ma_uint64 decoded = 0;
+    if (!utils_atomic_read_bool(&mic->finished)) {
+        ma_decoder_read_pcm_frames(&mic->decoder, frames, frame_count, &decoded);
+        if (decoded < frame_count) {
+            utils_atomic_write_bool(&mic->finished, true);
+        }
+    }
+    memset((float *) frames + decoded * WHISPER_CHANNELS, 0,
+           (size_t) (frame_count - decoded) * WHISPER_CHANNELS * sizeof(float));
+
+    // Hold the frames back until a microphone would have delivered them
+    mic->frames_delivered += frame_count;
+    double due = mic->started_at + (double) mic->frames_delivered / WHISPER_SAMPLE_RATE / mic->speed;
+    double wait = due - utils_now();
+    if (wait > 0) {
+        utils_sleep_ms((int) (wait * 1000.0));
+    }
+
+    if (frames_read) {
+        *frames_read = frame_count;
+    }
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_context_init(ma_context *context, const ma_context_config *config,
+                                          ma_backend_callbacks *callbacks) {
+    (void) context;
+    (void) config;
+    callbacks->onContextEnumerateDevices = virtual_mic_enumerate_devices;
+    callbacks->onContextGetDeviceInfo = virtual_mic_get_device_info;
+    callbacks->onDeviceInit = virtual_mic_device_init;
+    callbacks->onDeviceUninit = virtual_mic_device_uninit;
+    callbacks->onDeviceStart = virtual_mic_device_start;
+    callbacks->onDeviceStop = virtual_mic_device_stop;
+    callbacks->onDeviceRead = virtual_mic_device_read;
+    return MA_SUCCESS;
+}
+
+static ma_result virtual_mic_context_uninit(ma_context *context) {
+    (void) context;
+    return MA_SUCCESS;
+}
+
+bool audio_recorder_use_virtual_mic(const char *wav_path, double speed) {
+    if (g_recorder || g_virtual_mic.enabled || !wav_path || speed <= 0) {
+        return false; // Must be configured before the device exists
+    }
+
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, WHISPER_CHANNELS, WHISPER_SAMPLE_RATE);
+    if (ma_decoder_init_file(wav_path, &config, &g_virtual_mic.decoder) != MA_SUCCESS) {
+        log_error("Failed to open virtual microphone input: %s", wav_path);
+        return false;
+    }
+
+    g_virtual_mic.speed = speed > VIRTUAL_MIC_MAX_SPEED ? VIRTUAL_MIC_MAX_SPEED : speed;
+    g_virtual_mic.rewind = false;
+    g_virtual_mic.finished = false;
+    g_virtual_mic.enabled = true;
+    log_info("🎙️ Virtual microphone: %s at %.1fx speed", wav_path, g_virtual_mic.speed);
+    return true;
+}
+
+void audio_recorder_virtual_mic_rewind(void) {
+    if (g_virtual_mic.enabled) {
+        utils_atomic_write_bool(&g_virtual_mic.finished, false);
+        utils_atomic_write_bool(&g_virtual_mic.rewind, true);
+    }
+}
+
+bool audio_recorder_virtual_mic_finished(void) {
+    return g_virtual_mic.enabled && !utils_atomic_read_bool(&g_virtual_mic.rewind) &&
+           utils_atomic_read_bool(&g_virtual_mic.finished);
+}
+
 // Callback for audio input
 void data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
     AudioRecorder *recorder = (AudioRecorder *) pDevice->pUserData;
 
-    if (!recorder || !utils_atomic_read_bool(&recorder->is_recording) || !pInput) {
+    if (!recorder || !pInput) {
         return;
     }
 
-    const float *input = (const float *) pInput;
-    size_t samples = frameCount * WHISPER_CHANNELS;
+    bool recording = utils_atomic_read_bool(&recorder->is_recording);
+    if (!recording && !utils_atomic_read_bool(&recorder->is_monitoring)) {
+        return;
+    }
 
-    if (utils_atomic_read_bool(&recorder->is_file_recording)) {
+    if (recording && utils_atomic_read_bool(&recorder->is_file_recording)) {
         // Write to file
         ma_encoder_write_pcm_frames(&recorder->encoder, pInput, frameCount, NULL);
     } else {
-        // Write to buffer
-        if (recorder->buffer) {
-            // Resize buffer if needed
-            if (recorder->write_position + samples > recorder->buffer_capacity) {
-                size_t new_capacity = recorder->buffer_capacity * 2;
-                if (new_capacity < recorder->write_position + samples) {
-                    new_capacity = recorder->write_position + samples + 16384;
-                }
-
-                float *new_buffer = (float *) realloc(recorder->buffer, new_capacity * sizeof(float));
-                if (new_buffer) {
-                    recorder->buffer = new_buffer;
-                    recorder->buffer_capacity = new_capacity;
-                }
-            }
+        // Hand off to the drain thread
+        capture_rb_write(recorder, (const float *) pInput, frameCount);
+    }
 
-            // Copy data to buffer
-            if (recorder->write_position + samples <= recorder->buffer_capacity) {
-                memcpy(recorder->buffer + recorder->write_position, input, samples * sizeof(float));
-                recorder->write_position += samples;
-                recorder->buffer_size = recorder->write_position;
-            }
+    if (recording) {
+        if (recorder->total_frames == 0) {
+            recorder->first_frame_time = utils_now();
+            utils_atomic_write_bool(&recorder->first_frame_pending, true);
         }
+        recorder->total_frames += frameCount;
     }
 
-    recorder->total_frames += frameCount;
-
     (void) pOutput; // Unused
 }
 
+// Start the device together with its drain thread (memory recording and monitoring)
+static int start_capture_device(AudioRecorder *recorder) {
+    // Device is stopped, so there is no producer while resetting the ring
+    ma_pcm_rb_reset(&recorder->capture_rb);
+    recorder->dropped_frames = 0;
+
+    utils_atomic_write_bool(&recorder->drain_running, true);
+    recorder->drain_thread = utils_thread_create(drain_thread_proc, recorder);
+    if (!recorder->drain_thread) {
+        log_error("Failed to start audio drain thread");
+        utils_atomic_write_bool(&recorder->drain_running, false);
+        return -1;
+    }
+
+    if (ma_device_start(&recorder->device) != MA_SUCCESS) {
+        utils_atomic_write_bool(&recorder->drain_running, false);
+        utils_thread_join(recorder->drain_thread);
+        recorder->drain_thread = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Stop the device, wait for the drain thread and pick up whatever it left in the ring
+static void stop_capture_device(AudioRecorder *recorder) {
+    ma_device_stop(&recorder->device);
+
+    if (!recorder->drain_thread) {
+        trace_first_frame(recorder); // File recordings have no drain thread
+        return;
+    }
+
+    utils_atomic_write_bool(&recorder->drain_running, false);
+    utils_thread_join(recorder->drain_thread);
+    recorder->drain_thread = NULL;
+    trace_first_frame(recorder);
+
+    utils_mutex_lock(recorder->buffer_mutex);
+    capture_rb_drain(recorder);
+    utils_mutex_unlock(recorder->buffer_mutex);
+
+    if (recorder->dropped_frames > 0) {
+        log_error("Audio drain fell behind, dropped %llu frames", (unsigned long long) recorder->dropped_frames);
+    }
+}
+
+static void uninit_device(AudioRecorder *recorder) {
+    ma_device_uninit(&recorder->device);
+    if (recorder->has_context) {
+        ma_context_uninit(&recorder->context);
+    }
+}
+
 bool audio_recorder_init(void) {
     if (g_recorder) {
         return false; // Already initialized
@@ -98,19 +491,53 @@ bool audio_recorder_init(void) {
     deviceConfig.dataCallback = data_callback;
     deviceConfig.pUserData = g_recorder;
 
+    // The virtual microphone is the only backend of its own context
+    if (g_virtual_mic.enabled) {
+        ma_backend backends[] = {ma_backend_custom};
+        ma_context_config contextConfig = ma_context_config_init();
+        contextConfig.custom.onContextInit = virtual_mic_context_init;
+        contextConfig.custom.onContextUninit = virtual_mic_context_uninit;
+        if (ma_context_init(backends, 1, &contextConfig, &g_recorder->context) != MA_SUCCESS) {
+            log_error("Failed to initialize virtual microphone");
+            free(g_recorder);
+            g_recorder = NULL;
+            return false;
+        }
+        g_recorder->has_context = true;
+    }
+
     // Initialize device
-    if (ma_device_init(NULL, &deviceConfig, &g_recorder->device) != MA_SUCCESS) {
+    if (ma_device_init(g_recorder->has_context ? &g_recorder->context : NULL, &deviceConfig, &g_recorder->device) !=
+        MA_SUCCESS) {
         log_error("Failed to initialize audio device");
+        if (g_recorder->has_context) {
+            ma_context_uninit(&g_recorder->context);
+        }
+        free(g_recorder);
+        g_recorder = NULL;
+        return false;
+    }
+
+    // Preallocate the capture ring
+    if (ma_pcm_rb_init(ma_format_f32, WHISPER_CHANNELS, WHISPER_SAMPLE_RATE * CAPTURE_RING_SECONDS, NULL, NULL,
+                       &g_recorder->capture_rb) != MA_SUCCESS) {
+        log_error("Failed to allocate capture ring buffer");
+        uninit_device(g_recorder);
         free(g_recorder);
         g_recorder = NULL;
         return false;
     }
 
     // Allocate initial buffer for memory recording
-    g_recorder->buffer_capacity = WHISPER_SAMPLE_RATE * WHISPER_CHANNELS * 10; // 10 seconds initial
+    g_recorder->buffer_capacity = INITIAL_BUFFER_SAMPLES;
+    g_recorder->buffer_peak_capacity = INITIAL_BUFFER_SAMPLES;
     g_recorder->buffer = (float *) malloc(g_recorder->buffer_capacity * sizeof(float));
-    if (!g_recorder->buffer) {
-        ma_device_uninit(&g_recorder->device);
+    g_recorder->buffer_mutex = utils_mutex_create();
+    if (!g_recorder->buffer || !g_recorder->buffer_mutex) {
+        ma_pcm_rb_uninit(&g_recorder->capture_rb);
+        uninit_device(g_recorder);
+        free(g_recorder->buffer);
+        utils_mutex_destroy(g_recorder->buffer_mutex);
         free(g_recorder);
         g_recorder = NULL;
         return false;
@@ -124,6 +551,11 @@ int audio_recorder_start_file(const char *filename) {
         return -1;
     }
 
+    if (utils_atomic_read_bool(&g_recorder->is_monitoring)) {
+        log_error("File recording is not available while pre-roll capture is enabled");
+        return -1;
+    }
+
     // Setup encoder config
     ma_encoder_config encoderConfig =
         ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, WHISPER_CHANNELS, WHISPER_SAMPLE_RATE);
@@ -159,16 +591,33 @@ int audio_recorder_start(void) {
         return -1;
     }
 
-    // Reset buffer
-    g_recorder->write_position = 0;
-    g_recorder->buffer_size = 0;
-    utils_atomic_write_bool(&g_recorder->is_file_recording, false);
-    utils_atomic_write_bool(&g_recorder->is_recording, true);
     g_recorder->start_time = 0; // We'll track frames instead of time
     g_recorder->total_frames = 0;
+    utils_atomic_write_bool(&g_recorder->is_file_recording, false);
+
+    // Pre-roll mode: device is already running, seed the buffer with the history
+    if (utils_atomic_read_bool(&g_recorder->is_monitoring)) {
+        utils_mutex_lock(g_recorder->buffer_mutex);
+        capture_rb_drain(g_recorder);
+        reset_buffer(g_recorder);
+        preroll_flush_to_buffer(g_recorder);
+        g_recorder->capturing = true;
+        utils_mutex_unlock(g_recorder->buffer_mutex);
+
+        utils_atomic_write_bool(&g_recorder->is_recording, true);
+        return 0;
+    }
+
+    // Reset buffer
+    utils_mutex_lock(g_recorder->buffer_mutex);
+    reset_buffer(g_recorder);
+    g_recorder->capturing = true;
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+
+    utils_atomic_write_bool(&g_recorder->is_recording, true);
 
     // Start device
-    if (ma_device_start(&g_recorder->device) != MA_SUCCESS) {
+    if (start_capture_device(g_recorder) != 0) {
         utils_atomic_write_bool(&g_recorder->is_recording, false);
         return -1;
     }
@@ -181,8 +630,19 @@ int audio_recorder_stop(void) {
         return -1;
     }
 
+    // Pre-roll mode: keep the device running, just close the recording
+    if (utils_atomic_read_bool(&g_recorder->is_monitoring)) {
+        utils_mutex_lock(g_recorder->buffer_mutex);
+        capture_rb_drain(g_recorder);
+        g_recorder->capturing = false;
+        utils_mutex_unlock(g_recorder->buffer_mutex);
+
+        utils_atomic_write_bool(&g_recorder->is_recording, false);
+        return 0;
+    }
+
     // Stop device
-    ma_device_stop(&g_recorder->device);
+    stop_capture_device(g_recorder);
 
     // Clean up file recording
     if (utils_atomic_read_bool(&g_recorder->is_file_recording)) {
@@ -191,6 +651,10 @@ int audio_recorder_stop(void) {
         g_recorder->filename = NULL;
     }
 
+    utils_mutex_lock(g_recorder->buffer_mutex);
+    g_recorder->capturing = false;
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+
     utils_atomic_write_bool(&g_recorder->is_recording, false);
     utils_atomic_write_bool(&g_recorder->is_file_recording, false);
 
@@ -202,18 +666,62 @@ float *audio_recorder_get_samples(int *out_sample_count) {
         return NULL;
     }
 
+    utils_mutex_lock(g_recorder->buffer_mutex);
+
+    // Include anything still in flight if we are called mid-recording
+    capture_rb_drain(g_recorder);
     *out_sample_count = (int) g_recorder->buffer_size;
 
     // Create a copy of the buffer for the caller
+    float *copy = NULL;
     if (g_recorder->buffer_size > 0) {
-        float *copy = (float *) malloc(g_recorder->buffer_size * sizeof(float));
+        size_t bytes = g_recorder->buffer_size * sizeof(float);
+        copy = (float *) malloc(bytes);
         if (copy) {
-            memcpy(copy, g_recorder->buffer, g_recorder->buffer_size * sizeof(float));
+            memcpy(copy, g_recorder->buffer, bytes);
+            g_recorder->sample_copies_bytes += bytes;
+            if (g_recorder->sample_copies_bytes > g_recorder->sample_copies_peak_bytes) {
+                g_recorder->sample_copies_peak_bytes = g_recorder->sample_copies_bytes;
+            }
         }
-        return copy;
     }
 
-    return NULL;
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+    return copy;
+}
+
+void audio_recorder_free_samples(float *samples, int sample_count) {
+    if (!samples) {
+        return;
+    }
+
+    if (g_recorder && sample_count > 0) {
+        utils_mutex_lock(g_recorder->buffer_mutex);
+        size_t bytes = (size_t) sample_count * sizeof(float);
+        size_t live = g_recorder->sample_copies_bytes;
+        g_recorder->sample_copies_bytes = bytes < live ? live - bytes : 0;
+        utils_mutex_unlock(g_recorder->buffer_mutex);
+    }
+    free(samples);
+}
+
+int audio_recorder_read_samples(int offset, float *dst, int max_count) {
+    if (!g_recorder || !dst || offset < 0 || max_count <= 0) {
+        return 0;
+    }
+
+    utils_mutex_lock(g_recorder->buffer_mutex);
+
+    capture_rb_drain(g_recorder);
+    int count = 0;
+    if ((size_t) offset < g_recorder->buffer_size) {
+        size_t available = g_recorder->buffer_size - (size_t) offset;
+        count = available < (size_t) max_count ? (int) available : max_count;
+        memcpy(dst, g_recorder->buffer + offset, (size_t) count * sizeof(float));
+    }
+
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+    return count;
 }
 
 double audio_recorder_get_duration(void) {
@@ -228,6 +736,79 @@ bool audio_recorder_is_recording(void) {
     return g_recorder && utils_atomic_read_bool(&g_recorder->is_recording);
 }
 
+bool audio_recorder_get_memory_stats(AudioMemoryStats *stats) {
+    if (!stats) {
+        return false;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!g_recorder) {
+        return false;
+    }
+
+    utils_mutex_lock(g_recorder->buffer_mutex);
+    stats->capture_buffer_bytes = g_recorder->buffer_capacity * sizeof(float);
+    stats->capture_buffer_peak_bytes = g_recorder->buffer_peak_capacity * sizeof(float);
+    stats->capture_ring_bytes = (size_t) WHISPER_SAMPLE_RATE * CAPTURE_RING_SECONDS * WHISPER_CHANNELS * sizeof(float);
+    stats->preroll_bytes = g_recorder->preroll_capacity * sizeof(float);
+    stats->sample_copies_bytes = g_recorder->sample_copies_bytes;
+    stats->sample_copies_peak_bytes = g_recorder->sample_copies_peak_bytes;
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+    return true;
+}
+
+bool audio_recorder_set_preroll(int preroll_ms) {
+    if (!g_recorder || utils_atomic_read_bool(&g_recorder->is_recording)) {
+        return false;
+    }
+
+    if (preroll_ms < 0) {
+        preroll_ms = 0;
+    } else if (preroll_ms > MAX_PREROLL_MS) {
+        preroll_ms = MAX_PREROLL_MS;
+    }
+
+    // Tear down any previous monitoring session
+    if (utils_atomic_read_bool(&g_recorder->is_monitoring)) {
+        utils_atomic_write_bool(&g_recorder->is_monitoring, false);
+        stop_capture_device(g_recorder);
+    }
+
+    utils_mutex_lock(g_recorder->buffer_mutex);
+    free(g_recorder->preroll);
+    g_recorder->preroll = NULL;
+    g_recorder->preroll_capacity = 0;
+    g_recorder->preroll_pos = 0;
+    g_recorder->preroll_filled = 0;
+
+    if (preroll_ms > 0) {
+        size_t capacity = (size_t) WHISPER_SAMPLE_RATE * WHISPER_CHANNELS * preroll_ms / 1000;
+        g_recorder->preroll = (float *) malloc(capacity * sizeof(float));
+        if (g_recorder->preroll) {
+            g_recorder->preroll_capacity = capacity;
+        }
+    }
+    utils_mutex_unlock(g_recorder->buffer_mutex);
+
+    if (preroll_ms == 0) {
+        return true;
+    }
+
+    if (!g_recorder->preroll) {
+        log_error("Failed to allocate pre-roll buffer");
+        return false;
+    }
+
+    utils_atomic_write_bool(&g_recorder->is_monitoring, true);
+    if (start_capture_device(g_recorder) != 0) {
+        log_error("Failed to start audio device for pre-roll capture");
+        utils_atomic_write_bool(&g_recorder->is_monitoring, false);
+        return false;
+    }
+
+    log_info("🎙️ Pre-roll capture enabled (%d ms)", preroll_ms);
+    return true;
+}
+
 void audio_recorder_cleanup(void) {
     if (!g_recorder) {
         return;
@@ -238,10 +819,24 @@ void audio_recorder_cleanup(void) {
         audio_recorder_stop();
     }
 
+    // Stop pre-roll monitoring
+    if (utils_atomic_read_bool(&g_recorder->is_monitoring)) {
+        utils_atomic_write_bool(&g_recorder->is_monitoring, false);
+        stop_capture_device(g_recorder);
+    }
+
     // Clean up
-    ma_device_uninit(&g_recorder->device);
+    uninit_device(g_recorder);
+    ma_pcm_rb_uninit(&g_recorder->capture_rb);
+    utils_mutex_destroy(g_recorder->buffer_mutex);
     free(g_recorder->buffer);
+    free(g_recorder->preroll);
     free(g_recorder->filename);
     free(g_recorder);
     g_recorder = NULL;
+
+    if (g_virtual_mic.enabled) {
+        ma_decoder_uninit(&g_virtual_mic.decoder);
+        g_virtual_mic.enabled = false;
+    }
 }
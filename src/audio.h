@@ -26,8 +26,14 @@ int audio_recorder_stop(void);
 
 // Get the recorded audio samples
 // Returns pointer to audio data, count is written to out_sample_count
-// Caller must free the returned buffer
+// Release the returned buffer with audio_recorder_free_samples and the count it returned, so the
+// sample copies in AudioMemoryStats stay exact
 float *audio_recorder_get_samples(int *out_sample_count);
+void audio_recorder_free_samples(float *samples, int sample_count);
+
+// Copy up to max_count recorded samples starting at offset into dst, without copying the whole buffer.
+// Safe to call while recording. Returns the number of samples copied.
+int audio_recorder_read_samples(int offset, float *dst, int max_count);
 
 // Get recording duration in seconds
 double audio_recorder_get_duration(void);
@@ -35,4 +41,32 @@ double audio_recorder_get_duration(void);
 // Check if currently recording
 bool audio_recorder_is_recording(void);
 
+// Bytes held by the recorder, peaks are since audio_recorder_init
+typedef struct {
+    size_t capture_buffer_bytes; // Recording buffer capacity
+    size_t capture_buffer_peak_bytes;
+    size_t capture_ring_bytes; // Fixed ring between the audio callback and the drain thread
+    size_t preroll_bytes;
+    size_t sample_copies_bytes; // Returned by audio_recorder_get_samples and not freed yet
+    size_t sample_copies_peak_bytes;
+} AudioMemoryStats;
+
+// Returns false (and zeroes stats) if the recorder isn't initialized
+bool audio_recorder_get_memory_stats(AudioMemoryStats *stats);
+
+// Keep the device running and remember the last preroll_ms of audio, which is
+// prepended to the next memory recording. Start/stop then no longer touch the device.
+// Pass 0 to disable (default). Returns false if recording or the device can't be started.
+bool audio_recorder_set_preroll(int preroll_ms);
+
+// Virtual microphone for headless end-to-end tests: the capture device plays a WAV file through
+// miniaudio's custom backend instead of opening a sound card. Call before audio_recorder_init.
+// speed 1.0 delivers the audio in real time, 4.0 four times faster. After the end of the file
+// the microphone delivers silence until it is rewound.
+bool audio_recorder_use_virtual_mic(const char *wav_path, double speed);
+// Play the file from the start again, e.g. before each simulated key press
+void audio_recorder_virtual_mic_rewind(void);
+// True once the file has been played to the end since the last rewind
+bool audio_recorder_virtual_mic_finished(void);
+
 #endif // AUDIO_H
\ No newline at end of file
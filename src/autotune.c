@@ -0,0 +1,233 @@
+#include "autotune.h"
+#include "logging.h"
+#include "preferences.h"
+#include "transcription.h"
+#include "utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AUTOTUNE_SAMPLE_RATE 16000
+#define AUTOTUNE_CLIP_SAMPLES (AUTOTUNE_SAMPLE_RATE * 3) // A typical short dictation
+#define AUTOTUNE_RUNS 3
+#define AUTOTUNE_MAX_CANDIDATES 16
+#define AUTOTUNE_MAX_RETRIES 3 // Times a measurement is repeated because a dictation ran next to it
+#define AUTOTUNE_MIN_GAIN 0.97 // More threads must be at least 3% faster to win
+#define AUTOTUNE_GIVE_UP 1.10  // Stop once two larger counts are 10% slower than the best
+#define AUTOTUNE_PI 3.14159265358979323846
+
+static const char *model_filename(const char *path) {
+    const char *filename = strrchr(path, '/');
+    if (!filename) filename = strrchr(path, '\\');
+    return filename ? filename + 1 : path;
+}
+
+// "<model file>:threads" holds the count, "<model file>:threads_cpu" the CPU it was measured on
+static void threads_key(const char *model_path, const char *suffix, char *key, size_t size) {
+    snprintf(key, size, "%s:threads%s", model_filename(model_path), suffix);
+}
+
+static void cpu_fingerprint(char *fingerprint, size_t size) {
+    const char *name = utils_get_cpu_name();
+    snprintf(fingerprint, size, "%d x %s", utils_get_cpu_count(), name[0] ? name : "unknown CPU");
+}
+
+// Reference clip, generated so nothing has to be bundled: voiced syllables (130 Hz with harmonics
+// shaped like a vowel) at speaking rate. Loud enough for the silence fast path, VAD is bypassed.
+static void make_reference_clip(float *samples, int n_samples) {
+    for (int i = 0; i < n_samples; i++) {
+        double t = (double) i / AUTOTUNE_SAMPLE_RATE;
+        double syllable = fmod(t, 0.25);
+        double envelope = syllable < 0.2 ? sin(AUTOTUNE_PI * syllable / 0.2) : 0.0;
+        double f0 = 130.0 * (1.0 + 0.1 * sin(2.0 * AUTOTUNE_PI * 0.7 * t));
+        double value = 0.0;
+        for (int h = 1; h <= 20; h++) {
+            double frequency = f0 * h;
+            double formants =
+                exp(-pow((frequency - 700.0) / 250.0, 2)) + 0.5 * exp(-pow((frequency - 1200.0) / 300.0, 2));
+            value += (0.1 + formants) / h * sin(2.0 * AUTOTUNE_PI * frequency * t);
+        }
+        samples[i] = (float) (0.2 * envelope * value);
+    }
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static int inference_count(void) {
+    TranscriptionSkipStats stats;
+    transcription_get_skip_stats(&stats);
+    return stats.inferences;
+}
+
+// Median transcription latency in seconds at n_threads, negative on failure. The thread count and
+// VAD are passed per run, dictations running meanwhile keep the user's settings. A measurement a
+// dictation finished during is repeated, the two compete for the cores.
+static double time_threads(const float *clip, int n_samples, int n_threads, int runs) {
+    // The synthetic clip has no speech VAD would accept
+    TranscriptionOptions options = {n_threads, 0};
+    double times[AUTOTUNE_RUNS];
+    for (int attempt = 0;; attempt++) {
+        int inferences = inference_count();
+        for (int i = 0; i < runs; i++) {
+            double start = utils_now();
+            TranscriptionResult result =
+                transcription_run(clip, n_samples, AUTOTUNE_SAMPLE_RATE, NULL, NULL, &options);
+            times[i] = utils_now() - start;
+            if (!result.text) {
+                return -1.0;
+            }
+            free(result.text);
+        }
+        if (inference_count() - inferences == runs || attempt == AUTOTUNE_MAX_RETRIES) {
+            break;
+        }
+        log_info("🧵   %2d threads: a dictation ran meanwhile, measuring again", n_threads);
+    }
+    qsort(times, (size_t) runs, sizeof(double), compare_doubles);
+    return times[runs / 2];
+}
+
+// Thread counts worth timing, ascending: a coarse ladder below the core count, the core count and
+// the default count. Stores the index of the default in *start.
+static int candidate_threads(int *counts, int default_threads, int *start) {
+    static const int ladder[] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+    int cpus = utils_get_cpu_count();
+    default_threads = default_threads < cpus ? default_threads : cpus;
+    int n = 0;
+    for (size_t i = 0; i < sizeof(ladder) / sizeof(ladder[0]) && ladder[i] < cpus; i++) {
+        if (ladder[i] > default_threads && (n == 0 || counts[n - 1] < default_threads)) {
+            counts[n++] = default_threads;
+        }
+        if (ladder[i] != default_threads) {
+            counts[n++] = ladder[i];
+        }
+    }
+    if (n == 0 || counts[n - 1] < default_threads) {
+        counts[n++] = default_threads;
+    }
+    if (default_threads < cpus) {
+        counts[n++] = cpus;
+    }
+    *start = 0;
+    while (counts[*start] != default_threads) {
+        (*start)++;
+    }
+    return n;
+}
+
+typedef struct {
+    int best;
+    double best_time;
+    bool failed;
+} TuneSearch;
+
+// Time counts from index first in steps of step (1 up, -1 down) until two are clearly slower than
+// the best so far
+static void search_threads(TuneSearch *search, const float *clip, const int *counts, int n_counts, int first,
+                           int step) {
+    int slower = 0;
+    for (int i = first; !search->failed && i >= 0 && i < n_counts && slower < 2; i += step) {
+        double time = time_threads(clip, AUTOTUNE_CLIP_SAMPLES, counts[i], AUTOTUNE_RUNS);
+        if (time < 0) {
+            search->failed = true;
+            break;
+        }
+        log_info("🧵   %2d threads: %.0f ms", counts[i], time * 1000.0);
+
+        // More threads must be clearly faster to win, fewer win unless they are clearly slower
+        bool wins = step > 0 ? time < search->best_time * AUTOTUNE_MIN_GAIN
+                             : time * AUTOTUNE_MIN_GAIN <= search->best_time;
+        if (search->best == 0 || wins) {
+            search->best = counts[i];
+            search->best_time = time;
+            slower = 0;
+        } else if (time > search->best_time * AUTOTUNE_GIVE_UP) {
+            slower++;
+        }
+    }
+}
+
+bool autotune_apply(const char *model_path) {
+    if (!model_path) {
+        return true;
+    }
+    if (preferences_get_int("transcription_threads", 0) > 0 || !preferences_get_bool("thread_autotune", true)) {
+        transcription_set_thread_budget(0);
+        return true;
+    }
+
+    char key[256];
+    char fingerprint[320];
+    threads_key(model_path, "_cpu", key, sizeof(key));
+    cpu_fingerprint(fingerprint, sizeof(fingerprint));
+    const char *tuned_cpu = preferences_get_string(key);
+    if (!tuned_cpu || strcmp(tuned_cpu, fingerprint) != 0) {
+        if (tuned_cpu) {
+            log_info("🧵 CPU changed since the last thread autotune (%s), tuning again", tuned_cpu);
+        }
+        return false;
+    }
+
+    threads_key(model_path, "", key, sizeof(key));
+    int n_threads = preferences_get_int(key, 0);
+    if (n_threads <= 0) {
+        return false;
+    }
+
+    transcription_set_thread_budget(n_threads);
+    log_info("🧵 Using %d threads per transcription (autotuned for %s)", n_threads, model_filename(model_path));
+    return true;
+}
+
+int autotune_run(const char *model_path) {
+    if (!model_path) {
+        return 0;
+    }
+
+    float *clip = (float *) malloc(AUTOTUNE_CLIP_SAMPLES * sizeof(float));
+    if (!clip) {
+        return 0;
+    }
+    make_reference_clip(clip, AUTOTUNE_CLIP_SAMPLES);
+
+    // Start at the default count and walk the ladder up, then down, while it keeps getting faster
+    int counts[AUTOTUNE_MAX_CANDIDATES];
+    int first = 0;
+    int n_counts = candidate_threads(counts, transcription_get_thread_budget(), &first);
+    log_info("🧵 Autotuning threads for %s (%d candidates up to %d, starting at %d)", model_filename(model_path),
+             n_counts, counts[n_counts - 1], counts[first]);
+    double start = utils_now();
+
+    // Warm-up, the first inference after loading pays for allocations
+    TuneSearch search = {0, 0.0, time_threads(clip, AUTOTUNE_CLIP_SAMPLES, counts[first], 1) < 0};
+    search_threads(&search, clip, counts, n_counts, first, 1);
+    search_threads(&search, clip, counts, n_counts, first - 1, -1);
+    int best = search.failed ? 0 : search.best;
+    double best_time = search.best_time;
+    free(clip);
+
+    if (best == 0) {
+        log_error("Thread autotune failed, using the default thread count");
+        transcription_set_thread_budget(0);
+        return 0;
+    }
+
+    char key[256];
+    char fingerprint[320];
+    threads_key(model_path, "", key, sizeof(key));
+    preferences_set_int(key, best);
+    threads_key(model_path, "_cpu", key, sizeof(key));
+    cpu_fingerprint(fingerprint, sizeof(fingerprint));
+    preferences_set_string(key, fingerprint);
+    preferences_save();
+
+    transcription_set_thread_budget(best);
+    log_info("🧵 Autotune picked %d threads (%.0f ms per clip, tuning took %.1f s)", best, best_time * 1000.0,
+             utils_now() - start);
+    return best;
+}
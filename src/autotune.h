@@ -0,0 +1,18 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdbool.h>
+
+// Thread count autotuning - times a reference clip at several thread counts and stores the fastest
+// per model in preferences as "<model file>:threads". The CPU it was measured on is recorded next
+// to it, a result from another CPU is ignored and the model is tuned again.
+
+// Apply the stored thread count for the loaded model. Returns false if the model needs tuning.
+// Returns true without tuning if "thread_autotune" is off or "transcription_threads" is set.
+bool autotune_apply(const char *model_path);
+
+// Tune the loaded model (takes a few seconds, blocks), store and apply the result.
+// Returns the chosen thread count, 0 on failure.
+int autotune_run(const char *model_path);
+
+#endif // AUTOTUNE_H
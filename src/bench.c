@@ -0,0 +1,508 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "transcription.h"
+#include "utils.h"
+#include "vad.h"
+#include "wav.h"
+#include "wer.h"
+
+// yakety-bench: qualifies model and whisper.cpp upgrades on a corpus of recordings.
+// The corpus is a directory of 16 kHz WAV clips, each with an optional reference transcript
+// next to it (clip.wav + clip.txt). Every clip gets warm-up runs and timed runs, the report is JSON.
+// With --baseline, the report is compared against an earlier one and regressions fail the run.
+
+#define DEFAULT_RUNS 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_MAX_REGRESSION 10.0   // Percent, latency and peak memory
+#define DEFAULT_MAX_WER_INCREASE 1.0  // Percentage points
+#define EXIT_REGRESSION 2
+
+typedef struct {
+    char *name;
+    double audio_seconds;
+    double *latencies_ms; // Sorted after the runs
+    char *text;           // From the first timed run
+    char *reference;      // NULL without a transcript
+    int word_errors;
+    int reference_words;
+} ClipResult;
+
+typedef struct {
+    const char *corpus;
+    const char *model_path;
+    const char *output_path;
+    const char *baseline_path;
+    const char *language;
+    int runs;
+    int warmup;
+    int threads;
+    bool vad;
+    double max_regression;
+    double max_wer_increase;
+} BenchOptions;
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const double *sorted, int count, double p) {
+    if (count == 0) {
+        return 0.0;
+    }
+    int rank = (int) (p / 100.0 * count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+static char *join_path(const char *dir, const char *name) {
+    size_t len = strlen(dir) + strlen(name) + 2;
+    char *path = (char *) malloc(len);
+    if (path) {
+#ifdef _WIN32
+        snprintf(path, len, "%s\\%s", dir, name);
+#else
+        snprintf(path, len, "%s/%s", dir, name);
+#endif
+    }
+    return path;
+}
+
+// Whole text file, NULL if it doesn't exist
+static char *read_text_file(const char *path) {
+    FILE *file = utils_fopen_read_binary(path);
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *text = size >= 0 ? (char *) malloc((size_t) size + 1) : NULL;
+    if (text) {
+        size_t read = fread(text, 1, (size_t) size, file);
+        text[read] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+static void write_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *c = (const unsigned char *) (text ? text : ""); *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c == '\n') {
+            fputs("\\n", out);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Run one clip: warm-up, then timed runs. Stage timings of timed runs are added to stages.
+static bool bench_clip(const BenchOptions *options, const char *wav_name, ClipResult *clip,
+                       TranscriptionTimings *stages, int *inferred_runs) {
+    char *wav_path = join_path(options->corpus, wav_name);
+    WavFile wav = {0};
+    if (!wav_path || wav_read(wav_path, &wav) != 0) {
+        fprintf(stderr, "Skipping %s: failed to read WAV\n", wav_name);
+        free(wav_path);
+        return false;
+    }
+    if (wav.sample_rate != 16000) {
+        fprintf(stderr, "Skipping %s: %u Hz, the corpus must be 16 kHz\n", wav_name, wav.sample_rate);
+        free(wav.samples);
+        free(wav_path);
+        return false;
+    }
+
+    // clip.wav -> clip.txt
+    size_t stem_len = strlen(wav_path) - 4;
+    char *reference_path = (char *) malloc(stem_len + 5);
+    if (reference_path) {
+        memcpy(reference_path, wav_path, stem_len);
+        strcpy(reference_path + stem_len, ".txt");
+        clip->reference = read_text_file(reference_path);
+        free(reference_path);
+    }
+    free(wav_path);
+
+    clip->name = utils_strdup(wav_name);
+    clip->audio_seconds = (double) wav.sample_count / wav.sample_rate;
+    clip->latencies_ms = (double *) calloc((size_t) options->runs, sizeof(double));
+    if (!clip->latencies_ms) {
+        free(wav.samples);
+        return false;
+    }
+
+    for (int i = 0; i < options->warmup; i++) {
+        free(transcription_process(wav.samples, wav.sample_count, wav.sample_rate));
+    }
+
+    for (int i = 0; i < options->runs; i++) {
+        double start = utils_now();
+        TranscriptionResult result =
+            transcription_run(wav.samples, wav.sample_count, wav.sample_rate, NULL, NULL, NULL);
+        clip->latencies_ms[i] = (utils_now() - start) * 1000.0;
+
+        const TranscriptionTimings *t = &result.timings;
+        stages->vad_ms += t->vad_ms;
+        stages->mel_ms += t->mel_ms;
+        stages->encode_ms += t->encode_ms;
+        stages->decode_ms += t->decode_ms;
+        stages->postprocess_ms += t->postprocess_ms;
+        stages->n_sampled_tokens += t->n_sampled_tokens;
+        stages->n_decode_passes += t->n_decode_passes;
+        if (t->n_windows > 0) {
+            (*inferred_runs)++;
+        }
+
+        if (i == 0) {
+            clip->text = result.text ? result.text : utils_strdup("");
+        } else {
+            free(result.text);
+        }
+    }
+    qsort(clip->latencies_ms, (size_t) options->runs, sizeof(double), compare_doubles);
+
+    if (clip->reference) {
+        clip->word_errors = word_errors(clip->reference, clip->text, &clip->reference_words);
+    }
+
+    double median = percentile(clip->latencies_ms, options->runs, 50);
+    fprintf(stderr, "%-32s %6.2f s  median %8.1f ms  RTF %.3f%s\n", wav_name, clip->audio_seconds, median,
+            median / 1000.0 / clip->audio_seconds, clip->reference ? "" : "  (no reference)");
+    free(wav.samples);
+    return true;
+}
+
+// Summary numbers that are compared against a baseline
+typedef struct {
+    double p50_ms;
+    double p95_ms;
+    double wer; // Negative without references
+    double peak_rss_mb;
+} BenchSummary;
+
+static void write_report(FILE *out, const BenchOptions *options, const ClipResult *clips, int n_clips,
+                         const TranscriptionTimings *stages, int inferred_runs, const BenchSummary *summary) {
+    int total_runs = n_clips * options->runs;
+    double *all = (double *) malloc((size_t) (total_runs > 0 ? total_runs : 1) * sizeof(double));
+    double audio_seconds = 0.0;
+    double median_sum_ms = 0.0;
+    double latency_sum_ms = 0.0;
+    for (int c = 0; c < n_clips; c++) {
+        audio_seconds += clips[c].audio_seconds;
+        median_sum_ms += percentile(clips[c].latencies_ms, options->runs, 50);
+        for (int r = 0; r < options->runs; r++) {
+            latency_sum_ms += clips[c].latencies_ms[r];
+            if (all) {
+                all[c * options->runs + r] = clips[c].latencies_ms[r];
+            }
+        }
+    }
+    if (all) {
+        qsort(all, (size_t) total_runs, sizeof(double), compare_doubles);
+    }
+    double per_run = total_runs > 0 ? 1.0 / total_runs : 0.0;
+
+    fprintf(out, "{\n  \"model\": ");
+    write_json_string(out, options->model_path);
+    fprintf(out, ",\n  \"corpus\": ");
+    write_json_string(out, options->corpus);
+    fprintf(out, ",\n  \"runs\": %d,\n  \"warmup\": %d,\n  \"threads\": %d,\n  \"vad\": %s,\n", options->runs,
+            options->warmup, options->threads, options->vad ? "true" : "false");
+
+    fprintf(out, "  \"summary\": {\n");
+    fprintf(out, "    \"clips\": %d,\n    \"audio_seconds\": %.3f,\n", n_clips, audio_seconds);
+    fprintf(out, "    \"latency_ms\": {\"p50\": %.2f, \"p90\": %.2f, \"p95\": %.2f, \"p99\": %.2f, \"max\": %.2f, "
+                 "\"mean\": %.2f},\n",
+            summary->p50_ms, all ? percentile(all, total_runs, 90) : 0.0, summary->p95_ms,
+            all ? percentile(all, total_runs, 99) : 0.0, all ? percentile(all, total_runs, 100) : 0.0,
+            latency_sum_ms * per_run);
+    fprintf(out, "    \"rtf\": %.4f,\n", audio_seconds > 0 ? median_sum_ms / 1000.0 / audio_seconds : 0.0);
+    if (summary->wer >= 0) {
+        fprintf(out, "    \"wer\": %.4f,\n", summary->wer);
+    } else {
+        fprintf(out, "    \"wer\": null,\n");
+    }
+    fprintf(out, "    \"peak_rss_mb\": %.1f,\n", summary->peak_rss_mb);
+    fprintf(out, "    \"inferred_runs\": %d,\n", inferred_runs);
+    fprintf(out, "    \"stages_ms\": {\"vad\": %.2f, \"mel\": %.2f, \"encode\": %.2f, \"decode\": %.2f, "
+                 "\"postprocess\": %.2f},\n",
+            stages->vad_ms * per_run, stages->mel_ms * per_run, stages->encode_ms * per_run,
+            stages->decode_ms * per_run, stages->postprocess_ms * per_run);
+    fprintf(out, "    \"tokens_per_run\": %.1f,\n    \"decoder_passes_per_run\": %.2f\n  },\n",
+            stages->n_sampled_tokens * per_run, stages->n_decode_passes * per_run);
+
+    fprintf(out, "  \"clips\": [");
+    for (int c = 0; c < n_clips; c++) {
+        const ClipResult *clip = &clips[c];
+        double median = percentile(clip->latencies_ms, options->runs, 50);
+        fprintf(out, "%s\n    {\"name\": ", c > 0 ? "," : "");
+        write_json_string(out, clip->name);
+        fprintf(out, ", \"audio_seconds\": %.3f, \"latency_ms\": {\"min\": %.2f, \"p50\": %.2f, \"max\": %.2f}, "
+                     "\"rtf\": %.4f, ",
+                clip->audio_seconds, clip->latencies_ms[0], median, clip->latencies_ms[options->runs - 1],
+                median / 1000.0 / clip->audio_seconds);
+        if (clip->reference) {
+            fprintf(out, "\"wer\": %.4f, ", clip->reference_words > 0
+                                                ? (double) clip->word_errors / clip->reference_words
+                                                : (clip->word_errors > 0 ? 1.0 : 0.0));
+        } else {
+            fprintf(out, "\"wer\": null, ");
+        }
+        fprintf(out, "\"text\": ");
+        write_json_string(out, clip->text);
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+    free(all);
+}
+
+// Value of the first "key": number inside the report's summary object. Returns false if missing or null.
+static bool summary_number(const char *report, const char *key, double *value) {
+    const char *summary = strstr(report, "\"summary\"");
+    const char *clips = strstr(report, "\"clips\": [");
+    if (!summary) {
+        return false;
+    }
+
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *found = strstr(summary, pattern);
+    if (!found || (clips && found > clips)) {
+        return false;
+    }
+    char *end = NULL;
+    *value = strtod(found + strlen(pattern), &end);
+    return end != found + strlen(pattern);
+}
+
+// Print the comparison and return true if anything regressed beyond the tolerances
+static bool compare_baseline(const BenchOptions *options, const BenchSummary *current) {
+    char *baseline = read_text_file(options->baseline_path);
+    if (!baseline) {
+        fprintf(stderr, "Error: Could not read baseline %s\n", options->baseline_path);
+        return true;
+    }
+
+    bool regressed = false;
+    fprintf(stderr, "\n=== Baseline comparison (%s) ===\n", options->baseline_path);
+
+    const struct {
+        const char *key;
+        const char *label;
+        double value;
+    } relative[] = {
+        {"p50", "latency p50 ms", current->p50_ms},
+        {"p95", "latency p95 ms", current->p95_ms},
+        {"peak_rss_mb", "peak RSS MB", current->peak_rss_mb},
+    };
+    for (size_t i = 0; i < sizeof(relative) / sizeof(relative[0]); i++) {
+        double before;
+        if (!summary_number(baseline, relative[i].key, &before) || before <= 0) {
+            continue;
+        }
+        double change = (relative[i].value - before) / before * 100.0;
+        bool bad = change > options->max_regression;
+        fprintf(stderr, "%-16s %10.2f -> %10.2f  %+6.1f%%%s\n", relative[i].label, before, relative[i].value, change,
+                bad ? "  REGRESSION" : "");
+        regressed |= bad;
+    }
+
+    double before_wer;
+    if (current->wer >= 0 && summary_number(baseline, "wer", &before_wer)) {
+        double points = (current->wer - before_wer) * 100.0;
+        bool bad = points > options->max_wer_increase;
+        fprintf(stderr, "%-16s %9.2f%% -> %9.2f%%  %+6.2f pts%s\n", "WER", before_wer * 100.0, current->wer * 100.0,
+                points, bad ? "  REGRESSION" : "");
+        regressed |= bad;
+    }
+
+    free(baseline);
+    return regressed;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s --corpus <dir> [options]\n", program);
+    printf("Options:\n");
+    printf("  --corpus <dir>            Directory of 16 kHz WAV clips with optional <clip>.txt references\n");
+    printf("  --model <path>            Whisper model (default: bundled model)\n");
+    printf("  --runs <n>                Timed runs per clip (default %d)\n", DEFAULT_RUNS);
+    printf("  --warmup <n>              Untimed runs per clip (default %d)\n", DEFAULT_WARMUP);
+    printf("  --threads <n>             Inference threads, 0 = automatic (default 0)\n");
+    printf("  --language <code>         Transcription language (default en)\n");
+    printf("  --no-vad                  Transcribe without voice activity detection\n");
+    printf("  --output <file>           Write the JSON report to a file instead of stdout\n");
+    printf("  --baseline <file>         Compare against an earlier report, exit %d on regression\n", EXIT_REGRESSION);
+    printf("  --max-regression <pct>    Allowed latency/memory increase (default %.0f%%)\n", DEFAULT_MAX_REGRESSION);
+    printf("  --max-wer-increase <pts>  Allowed WER increase in percentage points (default %.1f)\n",
+           DEFAULT_MAX_WER_INCREASE);
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options = {0};
+    options.runs = DEFAULT_RUNS;
+    options.warmup = DEFAULT_WARMUP;
+    options.language = "en";
+    options.vad = true;
+    options.max_regression = DEFAULT_MAX_REGRESSION;
+    options.max_wer_increase = DEFAULT_MAX_WER_INCREASE;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--corpus") == 0 && has_value) {
+            options.corpus = argv[++i];
+        } else if (strcmp(argv[i], "--model") == 0 && has_value) {
+            options.model_path = argv[++i];
+        } else if (strcmp(argv[i], "--runs") == 0 && has_value) {
+            options.runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+            options.warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--language") == 0 && has_value) {
+            options.language = argv[++i];
+        } else if (strcmp(argv[i], "--no-vad") == 0) {
+            options.vad = false;
+        } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+            options.output_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+            options.baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-regression") == 0 && has_value) {
+            options.max_regression = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-wer-increase") == 0 && has_value) {
+            options.max_wer_increase = atof(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!options.corpus || options.runs < 1 || options.warmup < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (!options.model_path) {
+        options.model_path = utils_get_model_path();
+        if (!options.model_path) {
+            fprintf(stderr, "Error: Could not find Whisper model file\n");
+            return 1;
+        }
+    }
+
+    char **names = NULL;
+    int n_names = utils_list_dir(options.corpus, ".wav", &names);
+    if (n_names <= 0) {
+        fprintf(stderr, "Error: No WAV files in %s\n", options.corpus);
+        return 1;
+    }
+
+    // One state, so clips never share cores with each other
+    transcription_set_pool(1, options.threads);
+    if (transcription_init(options.model_path) != 0) {
+        fprintf(stderr, "Error: Failed to load model %s\n", options.model_path);
+        utils_free_names(names, n_names);
+        return 1;
+    }
+    transcription_set_language(options.language);
+    vad_setup();
+    const char *vad_model_path = utils_get_vad_model_path();
+    if (options.vad && vad_model_path && vad_init(vad_model_path) != 0) {
+        fprintf(stderr, "Warning: Failed to load VAD model, transcribing without it\n");
+    }
+
+    fprintf(stderr, "=== yakety-bench: %d clips, %d warm-up + %d timed runs each ===\n", n_names, options.warmup,
+            options.runs);
+
+    ClipResult *clips = (ClipResult *) calloc((size_t) n_names, sizeof(ClipResult));
+    TranscriptionTimings stages = {0};
+    int inferred_runs = 0;
+    int n_clips = 0;
+    for (int i = 0; clips && i < n_names; i++) {
+        if (bench_clip(&options, names[i], &clips[n_clips], &stages, &inferred_runs)) {
+            n_clips++;
+        }
+    }
+    utils_free_names(names, n_names);
+
+    int result = 0;
+    if (n_clips == 0) {
+        fprintf(stderr, "Error: No clip could be benchmarked\n");
+        result = 1;
+    } else {
+        int total_runs = n_clips * options.runs;
+        double *all = (double *) malloc((size_t) total_runs * sizeof(double));
+        int errors = 0;
+        int reference_words = 0;
+        bool has_references = false;
+        for (int c = 0; c < n_clips; c++) {
+            if (all) {
+                memcpy(all + c * options.runs, clips[c].latencies_ms, (size_t) options.runs * sizeof(double));
+            }
+            if (clips[c].reference) {
+                has_references = true;
+                errors += clips[c].word_errors;
+                reference_words += clips[c].reference_words;
+            }
+        }
+        if (all) {
+            qsort(all, (size_t) total_runs, sizeof(double), compare_doubles);
+        }
+
+        BenchSummary summary;
+        summary.p50_ms = all ? percentile(all, total_runs, 50) : 0.0;
+        summary.p95_ms = all ? percentile(all, total_runs, 95) : 0.0;
+        summary.wer = !has_references ? -1.0 : (reference_words > 0 ? (double) errors / reference_words : 0.0);
+        summary.peak_rss_mb = (double) utils_get_peak_rss() / (1024.0 * 1024.0);
+        free(all);
+
+        FILE *out = options.output_path ? utils_fopen_write(options.output_path) : stdout;
+        if (!out) {
+            fprintf(stderr, "Error: Could not write %s\n", options.output_path);
+            result = 1;
+        } else {
+            write_report(out, &options, clips, n_clips, &stages, inferred_runs, &summary);
+            if (out != stdout) {
+                fclose(out);
+                fprintf(stderr, "Report written to %s\n", options.output_path);
+            }
+        }
+
+        fprintf(stderr, "p50 %.1f ms, p95 %.1f ms, peak RSS %.1f MB", summary.p50_ms, summary.p95_ms,
+                summary.peak_rss_mb);
+        if (summary.wer >= 0) {
+            fprintf(stderr, ", WER %.2f%%", summary.wer * 100.0);
+        }
+        fprintf(stderr, "\n");
+
+        if (result == 0 && options.baseline_path && compare_baseline(&options, &summary)) {
+            fprintf(stderr, "FAILED: regression against baseline\n");
+            result = EXIT_REGRESSION;
+        }
+    }
+
+    for (int c = 0; c < n_clips; c++) {
+        free(clips[c].name);
+        free(clips[c].latencies_ms);
+        free(clips[c].text);
+        free(clips[c].reference);
+    }
+    free(clips);
+    transcription_cleanup();
+    vad_cleanup();
+    return result;
+}
@@ -18,9 +18,10 @@ void log_cleanup(void) {
 
 static void log_message(const char *level, const char *format, va_list args) {
     time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info); // Transcriptions log from several threads
     char time_buf[32];
-    strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", tm_info);
+    strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
 
     fprintf(stderr, "[%s] [%s] ", time_buf, level);
     vfprintf(stderr, format, args);
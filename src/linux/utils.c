@@ -1,12 +1,19 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // readahead
+#endif
 #include "utils.h"
 #include "logging.h"
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
@@ -241,6 +248,31 @@ void *utils_thread_id(void) {
     return (void *)(uintptr_t)pthread_self();
 }
 
+// Joinable threads
+struct utils_thread {
+    pthread_t thread;
+};
+
+utils_thread_t *utils_thread_create(async_work_fn work, void *arg) {
+    utils_thread_t *t = malloc(sizeof(utils_thread_t));
+    if (!t) return NULL;
+
+    if (pthread_create(&t->thread, NULL, work, arg) != 0) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void *utils_thread_join(utils_thread_t *thread) {
+    if (!thread) return NULL;
+
+    void *result = NULL;
+    pthread_join(thread->thread, &result);
+    free(thread);
+    return result;
+}
+
 // Async execution
 typedef struct {
     async_work_fn work;
@@ -293,3 +325,170 @@ void utils_execute_main_thread(int delay_ms, delay_callback_fn callback, void *a
         callback(arg);
     }
 }
+
+// Directory listing and memory usage
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static bool has_extension(const char *name, const char *extension) {
+    size_t len = strlen(name);
+    size_t ext_len = strlen(extension);
+    return len > ext_len && strcasecmp(name + len - ext_len, extension) == 0;
+}
+
+int utils_list_dir(const char *dir, const char *extension, char ***names) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    char **list = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.' || !has_extension(entry->d_name, extension)) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            char **new_list = realloc(list, capacity * sizeof(char *));
+            if (!new_list) {
+                break;
+            }
+            list = new_list;
+        }
+        list[count] = utils_strdup(entry->d_name);
+        if (list[count]) {
+            count++;
+        }
+    }
+    closedir(handle);
+
+    if (count > 0) {
+        qsort(list, count, sizeof(char *), compare_names);
+    }
+    *names = list;
+    return count;
+}
+
+void utils_free_names(char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+size_t utils_get_peak_rss(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (size_t) usage.ru_maxrss * 1024; // Kilobytes on Linux
+}
+
+const void *utils_map_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+    *size = (size_t) st.st_size;
+    return data;
+}
+
+void utils_unmap_file(const void *data, size_t size) {
+    if (data) {
+        munmap((void *) data, size);
+    }
+}
+
+bool utils_prefetch_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+    int result = readahead(fd, 0, (size_t) st.st_size); // Waits for the reads the advice queued
+    close(fd);
+    *size = (size_t) st.st_size;
+    return result == 0;
+}
+
+bool utils_lock_memory(const void *data, size_t size) {
+    return data && mlock(data, size) == 0;
+}
+
+void utils_unlock_memory(const void *data, size_t size) {
+    if (data) {
+        munlock(data, size);
+    }
+}
+
+size_t utils_get_rss(void) {
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (!file) {
+        return 0;
+    }
+    unsigned long pages = 0;
+    int fields = fscanf(file, "%*s %lu", &pages);
+    fclose(file);
+    return fields == 1 ? (size_t) pages * (size_t) sysconf(_SC_PAGESIZE) : 0;
+}
+
+int utils_get_open_handle_count(void) {
+    DIR *dir = opendir("/proc/self/fd");
+    if (!dir) {
+        return -1;
+    }
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count - 1; // Not counting the descriptor of dir itself
+}
+
+int utils_get_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int) count : 1;
+}
+
+const char *utils_get_cpu_name(void) {
+    static char name[256] = {0};
+    if (name[0] != '\0') return name;
+
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if (!file) return name;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "model name", 10) != 0) continue;
+        char *value = strchr(line, ':');
+        if (!value) continue;
+        value++;
+        while (*value == ' ' || *value == '\t') value++;
+        value[strcspn(value, "\n")] = '\0';
+        snprintf(name, sizeof(name), "%s", value);
+        break;
+    }
+    fclose(file);
+    return name;
+}
@@ -5,9 +5,16 @@
 #import <AppKit/AppKit.h>
 #import <Foundation/Foundation.h>
 #import <ServiceManagement/ServiceManagement.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mach/mach.h>
 #include <pthread.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/sysctl.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -440,3 +447,196 @@ void utils_mutex_unlock(utils_mutex_t* mutex) {
 void* utils_thread_id(void) {
     return (void*)pthread_self();
 }
+
+// Joinable thread implementation using pthread
+struct utils_thread {
+    pthread_t thread;
+};
+
+utils_thread_t* utils_thread_create(async_work_fn work, void* arg) {
+    utils_thread_t* t = malloc(sizeof(utils_thread_t));
+    if (!t) return NULL;
+
+    if (pthread_create(&t->thread, NULL, work, arg) != 0) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void* utils_thread_join(utils_thread_t* thread) {
+    if (!thread) return NULL;
+
+    void* result = NULL;
+    pthread_join(thread->thread, &result);
+    free(thread);
+    return result;
+}
+
+// Directory listing and memory usage
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static bool has_extension(const char *name, const char *extension) {
+    size_t len = strlen(name);
+    size_t ext_len = strlen(extension);
+    return len > ext_len && strcasecmp(name + len - ext_len, extension) == 0;
+}
+
+int utils_list_dir(const char *dir, const char *extension, char ***names) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    char **list = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.' || !has_extension(entry->d_name, extension)) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            char **new_list = realloc(list, capacity * sizeof(char *));
+            if (!new_list) {
+                break;
+            }
+            list = new_list;
+        }
+        list[count] = utils_strdup(entry->d_name);
+        if (list[count]) {
+            count++;
+        }
+    }
+    closedir(handle);
+
+    if (count > 0) {
+        qsort(list, count, sizeof(char *), compare_names);
+    }
+    *names = list;
+    return count;
+}
+
+void utils_free_names(char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+size_t utils_get_peak_rss(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (size_t) usage.ru_maxrss; // Bytes on macOS
+}
+
+const void *utils_map_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+    *size = (size_t) st.st_size;
+    return data;
+}
+
+void utils_unmap_file(const void *data, size_t size) {
+    if (data) {
+        munmap((void *) data, size);
+    }
+}
+
+bool utils_prefetch_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // Advise in chunks, the count is an int. The reads are queued, read them to wait for them.
+    for (off_t offset = 0; offset < st.st_size; offset += 1 << 30) {
+        struct radvisory advice = {offset, (int) MIN(st.st_size - offset, 1 << 30)};
+        fcntl(fd, F_RDADVISE, &advice);
+    }
+    char *buffer = malloc(1 << 20);
+    bool ok = buffer != NULL;
+    while (ok) {
+        ssize_t n = read(fd, buffer, 1 << 20);
+        ok = n >= 0;
+        if (n <= 0) {
+            break;
+        }
+    }
+    free(buffer);
+    close(fd);
+    *size = (size_t) st.st_size;
+    return ok;
+}
+
+bool utils_lock_memory(const void *data, size_t size) {
+    return data && mlock(data, size) == 0;
+}
+
+void utils_unlock_memory(const void *data, size_t size) {
+    if (data) {
+        munlock(data, size);
+    }
+}
+
+size_t utils_get_rss(void) {
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return (size_t) info.resident_size;
+}
+
+int utils_get_open_handle_count(void) {
+    DIR *dir = opendir("/dev/fd");
+    if (!dir) {
+        return -1;
+    }
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count - 1; // Not counting the descriptor of dir itself
+}
+
+int utils_get_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int) count : 1;
+}
+
+const char *utils_get_cpu_name(void) {
+    static char name[256] = {0};
+    if (name[0] == '\0') {
+        size_t size = sizeof(name);
+        if (sysctlbyname("machdep.cpu.brand_string", name, &size, NULL, 0) != 0) {
+            name[0] = '\0';
+        }
+    }
+    return name;
+}
@@ -11,25 +11,65 @@
 #include "clipboard.h"
 #include "keylogger.h"
 #include "logging.h"
+#include "mel.h"
 #include "menu.h"
+#include "metrics.h"
 #include "models.h"
 #include "overlay.h"
 #include "preferences.h"
+#include "prefetch.h"
+#include "streaming.h"
+#include "trace.h"
 #include "transcription.h"
+#include "transcription_queue.h"
 #include "utils.h"
+#include "vad.h"
 
 #include "dialog.h"
 
 // Constants
 #define MIN_RECORDING_DURATION 0.1
+#define MODEL_WAIT_MS 10
+#define AUDIO_WAIT_MS 10
+#define AUDIO_WAIT_TIMEOUT_MS 5000
 
 typedef struct {
-    bool recording;
+    bool recording; // Atomic access required, read by the transcription worker
     double recording_start_time;
+    StreamingSession *stream;
+    MelSession *mel;
 } AppState;
 
+// A released recording waiting for the transcription worker
+typedef struct {
+    float *samples;
+    int sample_count;
+    double stop_start;
+    StreamingSession *stream;
+    MelSession *mel;
+    int generation; // g_generation when the job was queued
+    double queued_at;
+} TranscriptionJob;
+
 static AppState *g_state = NULL;
 
+// --stats: log where the memory goes after loading and after every transcription
+static bool g_memory_stats = false;
+
+// The audio device opens on its own thread while the app starts, on_app_ready waits for it after
+// the hotkey and menu are up
+static utils_thread_t *g_audio_thread = NULL;
+static bool g_audio_opened = false; // Result of audio_recorder_init, read after joining g_audio_thread
+static bool g_audio_ready = false;  // Atomic access required, set once recording can start
+static bool g_audio_failed = false; // Atomic access required, the device could not be opened
+static bool g_startup_failed = false;
+
+// Bumped on quit to drop every transcription still queued
+static int g_generation = 0; // Atomic access required
+// Token of the job the worker is running, guarded by g_cancel_mutex
+static utils_mutex_t *g_cancel_mutex = NULL;
+static TranscriptionCancel *g_running_cancel = NULL;
+
 // Forward declarations
 static void on_key_press(void *userdata);
 static void on_key_release(void *userdata);
@@ -40,6 +80,53 @@ static void signal_handler(int sig) {
     app_quit();
 }
 
+static void *init_audio_work(void *arg) {
+    (void) arg;
+    double start = utils_now();
+    g_audio_opened = audio_recorder_init();
+    log_info("Audio recorder initialized in the background (took %.0f ms)", (utils_now() - start) * 1000.0);
+    return NULL;
+}
+
+// Wait for the audio device opened by app_main, then start the optional pre-roll capture
+static bool finish_audio_init(void) {
+    if (!g_audio_thread) {
+        return g_audio_opened;
+    }
+    utils_thread_join(g_audio_thread);
+    g_audio_thread = NULL;
+    if (!g_audio_opened) {
+        log_error("Failed to initialize audio recorder");
+        utils_atomic_write_bool(&g_audio_failed, true);
+        return false;
+    }
+
+    // Optional always-on capture so the first syllable before the key press is kept
+    int preroll_ms = preferences_get_int("preroll_ms", 0);
+    if (preroll_ms > 0 && !audio_recorder_set_preroll(preroll_ms)) {
+        log_error("Failed to enable pre-roll capture, falling back to on-demand recording");
+    }
+    utils_atomic_write_bool(&g_audio_ready, true);
+    return true;
+}
+
+// The keylogger starts before on_app_ready has waited for the audio device. Where key callbacks run
+// on their own thread (Linux) a press can arrive meanwhile, hold it until recording can start.
+static bool wait_for_audio(void) {
+    if (utils_atomic_read_bool(&g_audio_ready)) {
+        return true;
+    }
+    log_info("🎤 Waiting for the microphone to open");
+    for (int waited = 0; !utils_atomic_read_bool(&g_audio_ready); waited += AUDIO_WAIT_MS) {
+        if (waited >= AUDIO_WAIT_TIMEOUT_MS || utils_atomic_read_bool(&g_audio_failed)) {
+            log_error("Microphone is not available, hotkey ignored");
+            return false;
+        }
+        utils_sleep_ms(AUDIO_WAIT_MS);
+    }
+    return true;
+}
+
 // Model loading with unified system
 static bool load_model_with_fallback(void) {
     if (models_load() == 0) {
@@ -126,12 +213,202 @@ static void handle_first_run(void) {
     }
 }
 
-// Process recorded audio - extract from on_key_release
-static void process_recorded_audio(double duration) {
+// Copy transcribed text to the clipboard and paste it
+static void paste_transcription(char *text, double stop_start, double clip_seconds) {
+    if (text && strlen(text) > 0) {
+        // Text is already cleaned and has trailing space from transcription_process
+        double clipboard_start = utils_now();
+        clipboard_copy(text);
+        double paste_start = utils_now();
+        clipboard_paste();
+        double clipboard_duration = utils_now() - clipboard_start;
+        trace_span("clipboard copy", clipboard_start, paste_start);
+        trace_span("paste", paste_start, clipboard_start + clipboard_duration);
+        trace_span("key up to paste", stop_start, clipboard_start + clipboard_duration);
+
+        log_info("📝 \"%s\"", text);
+        log_info("✅ Text pasted! (clipboard operations took %.0f ms)", clipboard_duration * 1000.0);
+
+        double total_time = utils_now() - stop_start;
+        log_info("⏱️  Total time from stop to paste: %.0f ms", total_time * 1000.0);
+        metrics_record(METRIC_STOP_TO_PASTE, total_time, clip_seconds);
+
+        free(text);
+    } else {
+        log_info("⚠️  No speech detected");
+        if (text)
+            free(text);
+    }
+}
+
+static void log_memory_stats(const char *when) {
+    const double mb = 1024.0 * 1024.0;
+    TranscriptionMemoryStats whisper;
+    AudioMemoryStats audio;
+    transcription_get_memory_stats(&whisper);
+    audio_recorder_get_memory_stats(&audio);
+
+    log_info("📊 Memory %s: RSS %.1f MB (peak RSS %.1f MB), whisper model with %d of %d states created", when,
+             utils_get_rss() / mb, utils_get_peak_rss() / mb, whisper.n_created, whisper.n_states);
+    log_info("📊   capture buffer %.1f MB (peak %.1f MB), ring %.1f MB, pre-roll %.1f MB, sample copies %.1f MB "
+             "(peak %.1f MB)",
+             audio.capture_buffer_bytes / mb, audio.capture_buffer_peak_bytes / mb, audio.capture_ring_bytes / mb,
+             audio.preroll_bytes / mb, audio.sample_copies_bytes / mb, audio.sample_copies_peak_bytes / mb);
+}
+
+// Hide the overlay unless a new recording already started while this job was queued
+static void hide_overlay_if_idle(void) {
+    if (!g_state || !utils_atomic_read_bool(&g_state->recording)) {
+        overlay_hide();
+    }
+}
+
+// Abort the running transcription and drop everything still queued, on quit. New recordings never
+// cancel earlier ones, those were finished dictations and still paste.
+static void cancel_transcriptions(void) {
+    utils_atomic_write_int(&g_generation, utils_atomic_read_int(&g_generation) + 1);
+    if (g_cancel_mutex) {
+        utils_mutex_lock(g_cancel_mutex);
+        transcription_cancel(g_running_cancel);
+        utils_mutex_unlock(g_cancel_mutex);
+    }
+}
+
+static void set_running_cancel(TranscriptionCancel *cancel) {
+    if (g_cancel_mutex) {
+        utils_mutex_lock(g_cancel_mutex);
+        g_running_cancel = cancel;
+        utils_mutex_unlock(g_cancel_mutex);
+    }
+}
+
+// Runs on the transcription worker
+static void run_transcription_job(void *arg) {
+    TranscriptionJob *job = (TranscriptionJob *) arg;
+    double job_start = utils_now();
+    trace_span("queued", job->queued_at, job_start);
+    double clip_seconds = (double) job->sample_count / 16000.0;
+
+    // The deadline counts from key release, time spent queued is latency too
+    TranscriptionCancel cancel;
+    int timeout_ms = preferences_get_int("transcription_timeout_ms", 60000);
+    transcription_cancel_init(&cancel, 0);
+    if (timeout_ms > 0) {
+        cancel.deadline = job->stop_start + timeout_ms / 1000.0;
+    }
+    set_running_cancel(&cancel);
+    if (job->generation != utils_atomic_read_int(&g_generation)) {
+        transcription_cancel(&cancel);
+    }
+
+    // Recorded while the model was still loading, the hotkey works before it is ready
+    if (models_is_loading() && !transcription_is_cancelled(&cancel)) {
+        log_info("⏳ Waiting for the model to finish loading");
+        while (models_is_loading() && !transcription_is_cancelled(&cancel)) {
+            utils_sleep_ms(MODEL_WAIT_MS);
+        }
+    }
+
+    if (transcription_is_cancelled(&cancel)) {
+        // Quitting, or the deadline passed before the job got to run
+        log_info("🛑 Dropping queued transcription");
+        streaming_cancel(job->stream);
+        mel_session_cancel(job->mel);
+        hide_overlay_if_idle();
+    } else if (job->stream) {
+        // Streaming mode: most windows are already transcribed, only the tail is left
+        double finish_start = utils_now();
+        char *text = streaming_finish(job->stream, job->samples, job->sample_count, &cancel);
+        hide_overlay_if_idle();
+        log_info("⏱️  Streaming transcription tail took: %.0f ms", (utils_now() - finish_start) * 1000.0);
+        if (transcription_is_cancelled(&cancel)) {
+            log_info("🛑 Streaming transcription cancelled");
+            free(text);
+        } else {
+            paste_transcription(text, job->stop_start, clip_seconds);
+        }
+    } else if (job->samples && job->sample_count > 0) {
+        // Drop the silence before and after speaking, encoder cost scales with input length
+        int start = 0;
+        int count = job->sample_count;
+        if (preferences_get_bool("trim_silence", true)) {
+            double trim_start = utils_now();
+            count = vad_trim_silence(job->samples, job->sample_count, preferences_get_int("trim_padding_ms", 250), &start);
+            trace_span("trim silence", trim_start, utils_now());
+            log_info("✂️  Trimmed silence: %d -> %d samples (%.2f -> %.2f seconds)", job->sample_count, count,
+                     (float) job->sample_count / 16000.0f, (float) count / 16000.0f);
+        }
+
+        log_info("🧠 Starting transcription of %.2f seconds of audio...", (float) count / 16000.0f);
+
+        double transcribe_start = utils_now();
+        MelCache *mel = mel_session_finish(job->mel, job->samples, job->sample_count);
+        trace_span("mel session finish", transcribe_start, utils_now());
+        TranscriptionResult result = transcription_run(job->samples + start, count, 16000, mel, &cancel, NULL);
+        char *text = result.text;
+        mel_cache_free(mel);
+        double transcribe_duration = utils_now() - transcribe_start;
+        hide_overlay_if_idle();
+        log_info("⏱️  Full transcription pipeline took: %.0f ms", transcribe_duration * 1000.0);
+
+        if (text && result.timings.n_windows > 0) {
+            metrics_record(METRIC_INFERENCE, result.timings.total_ms / 1000.0, clip_seconds);
+            metrics_record(METRIC_RTF, result.timings.total_ms / 1000.0 / ((double) count / 16000.0), clip_seconds);
+        }
+        if (!transcription_is_cancelled(&cancel)) {
+            paste_transcription(text, job->stop_start, clip_seconds);
+        }
+    } else {
+        mel_session_cancel(job->mel);
+        hide_overlay_if_idle();
+    }
+
+    set_running_cancel(NULL);
+    trace_span("transcription job", job_start, utils_now());
+    metrics_flush();
+    if (g_memory_stats) {
+        log_memory_stats("after transcription");
+    }
+    audio_recorder_free_samples(job->samples, job->sample_count);
+    free(job);
+}
+
+// Run on the transcription worker so joining session workers never blocks the key thread
+static void run_streaming_cancel_job(void *arg) {
+    streaming_cancel((StreamingSession *) arg);
+}
+
+static void run_mel_cancel_job(void *arg) {
+    mel_session_cancel((MelSession *) arg);
+}
+
+static void cancel_sessions(AppState *state) {
+    if (state->stream) {
+        streaming_stop(state->stream);
+        if (!transcription_queue_push(run_streaming_cancel_job, state->stream)) {
+            streaming_cancel(state->stream);
+        }
+        state->stream = NULL;
+    }
+    if (state->mel) {
+        mel_session_stop(state->mel);
+        if (!transcription_queue_push(run_mel_cancel_job, state->mel)) {
+            mel_session_cancel(state->mel);
+        }
+        state->mel = NULL;
+    }
+}
+
+// Process recorded audio - extract from on_key_release. Only snapshots the recording and
+// hands it to the transcription worker, so the key thread is free for the next recording.
+static void process_recorded_audio(AppState *state, double duration) {
     log_info("🔴 Recorded for %.2f seconds", duration);
     double stop_start = utils_now();
+    streaming_stop(state->stream);
+    mel_session_stop(state->mel);
     audio_recorder_stop();
     double stop_duration = utils_now() - stop_start;
+    trace_span("device stop", stop_start, stop_start + stop_duration);
     log_info("⏱️  Audio stop took: %.0f ms", stop_duration * 1000.0);
 
     // Get recorded audio
@@ -139,54 +416,69 @@ static void process_recorded_audio(double duration) {
     int sample_count = 0;
     float *samples = audio_recorder_get_samples(&sample_count);
     double get_samples_duration = utils_now() - get_samples_start;
+    trace_span("sample copy", get_samples_start, get_samples_start + get_samples_duration);
     log_info("⏱️  Getting audio samples took: %.0f ms (%d samples)", get_samples_duration * 1000.0, sample_count);
 
-    if (samples && sample_count > 0) {
-        log_info("🧠 Starting transcription of %.2f seconds of audio...", (float) sample_count / 16000.0f);
-        overlay_show("Transcribing");
-
-        double transcribe_start = utils_now();
-        char *text = transcription_process(samples, sample_count, 16000);
-        double transcribe_duration = utils_now() - transcribe_start;
+    TranscriptionJob *job = (TranscriptionJob *) calloc(1, sizeof(TranscriptionJob));
+    if (!job) {
+        log_error("Failed to allocate transcription job");
+        audio_recorder_free_samples(samples, sample_count);
+        cancel_sessions(state);
         overlay_hide();
-        log_info("⏱️  Full transcription pipeline took: %.0f ms", transcribe_duration * 1000.0);
-
-        if (text && strlen(text) > 0) {
-            // Text is already cleaned and has trailing space from transcription_process
-            double clipboard_start = utils_now();
-            clipboard_copy(text);
-            clipboard_paste();
-            double clipboard_duration = utils_now() - clipboard_start;
-
-            log_info("📝 \"%s\"", text);
-            log_info("✅ Text pasted! (clipboard operations took %.0f ms)", clipboard_duration * 1000.0);
-
-            double total_time = utils_now() - stop_start;
-            log_info("⏱️  Total time from stop to paste: %.0f ms", total_time * 1000.0);
-
-            free(text);
-        } else {
-            log_info("⚠️  No speech detected");
-            if (text)
-                free(text);
-        }
-
-        free(samples);
+        return;
+    }
+    job->samples = samples;
+    job->sample_count = sample_count;
+    job->stop_start = stop_start;
+    job->stream = state->stream;
+    job->mel = state->mel;
+    job->generation = utils_atomic_read_int(&g_generation);
+    job->queued_at = utils_now();
+    state->stream = NULL;
+    state->mel = NULL;
+
+    overlay_show("Transcribing");
+    if (!transcription_queue_push(run_transcription_job, job)) {
+        // Worker unavailable, transcribe on this thread like before
+        run_transcription_job(job);
     }
 }
 
 static void on_key_press(void *userdata) {
     AppState *state = (AppState *) userdata;
 
-    if (!state->recording) {
-        state->recording = true;
+    if (!utils_atomic_read_bool(&state->recording)) {
+        double key_down = utils_now();
+        trace_instant("key down", key_down);
+        if (!wait_for_audio()) {
+            return;
+        }
+
+        // The warm-up after loading would only slow this dictation down, earlier ones still paste
+        transcription_warm_up_cancel();
+        utils_atomic_write_bool(&state->recording, true);
         state->recording_start_time = utils_get_time();
 
-        if (audio_recorder_start() == 0) {
+        double device_start = utils_now();
+        int start_result = audio_recorder_start();
+        trace_span("device start", device_start, utils_now());
+        if (start_result == 0) {
             overlay_show("Recording");
+
+            if (preferences_get_bool("streaming_enabled", false)) {
+                state->stream = streaming_start();
+                if (!state->stream) {
+                    log_error("Failed to start streaming transcription, transcribing after release instead");
+                }
+            }
+
+            // Batch transcription: compute the spectrogram while the key is held
+            if (!state->stream && preferences_get_bool("incremental_mel", true)) {
+                state->mel = mel_session_start();
+            }
         } else {
             log_error("Failed to start recording");
-            state->recording = false;
+            utils_atomic_write_bool(&state->recording, false);
         }
     }
 }
@@ -194,31 +486,34 @@ static void on_key_press(void *userdata) {
 static void on_key_release(void *userdata) {
     AppState *state = (AppState *) userdata;
 
-    if (state->recording) {
-        state->recording = false;
+    if (utils_atomic_read_bool(&state->recording)) {
+        trace_instant("key up", utils_now());
+        utils_atomic_write_bool(&state->recording, false);
         double duration = utils_get_time() - state->recording_start_time;
 
         // Minimum recording duration check
         if (duration < MIN_RECORDING_DURATION) {
             log_info("⚠️  Recording too brief (%.2f seconds), ignoring", duration);
+            cancel_sessions(state);
             audio_recorder_stop();
             overlay_hide();
             return;
         }
 
         // Process the recorded audio
-        process_recorded_audio(duration);
+        process_recorded_audio(state, duration);
     }
 }
 
 static void on_key_cancel(void *userdata) {
     AppState *state = (AppState *) userdata;
 
-    if (state->recording) {
-        state->recording = false;
+    if (utils_atomic_read_bool(&state->recording)) {
+        utils_atomic_write_bool(&state->recording, false);
         log_info("❌ Recording cancelled - additional key pressed");
 
-        // Stop recording and clean up
+        // Stop recording and clean up, earlier dictations still paste
+        cancel_sessions(state);
         audio_recorder_stop();
         overlay_hide();
 
@@ -230,32 +525,47 @@ static void on_key_cancel(void *userdata) {
 static void on_app_ready(void) {
     log_info("on_app_ready called - starting initialization (%.0f ms since app start)", utils_now() * 1000.0);
 
-    // Step 1: Load model with fallback
-    if (!load_model_with_fallback()) {
-        return; // Model loading failed and quit was called
+    // Step 1: Start loading the Whisper and VAD models in the background
+    models_load_start();
+
+    // Step 2: Setup keylogger with permission handling, the hotkey works while the models load and
+    // dictations recorded meanwhile wait for them
+    if (!setup_keylogger()) {
+        return; // Keylogger setup failed and quit was called
     }
+    log_info("⌨️  Hotkey ready %.0f ms after app start", utils_now() * 1000.0);
 
-    // Step 2: Setup menu system
+    // Step 3: Setup menu system
     if (!setup_menu_if_needed()) {
         return; // Menu setup failed and quit was called
     }
 
-    // Step 3: Setup keylogger with permission handling
-    if (!setup_keylogger()) {
-        return; // Keylogger setup failed and quit was called
+    // Step 4: Wait for the audio device opened by app_main, recording needs it from the first key press
+    if (!finish_audio_init()) {
+        g_startup_failed = true;
+        app_quit();
+        return;
+    }
+
+    // Step 5: Wait for the models (keeping the event loop running), with fallback
+    if (!load_model_with_fallback()) {
+        return; // Model loading failed and quit was called
     }
 
-// Step 4: Log startup completion
+// Step 6: Log startup completion
 #ifdef _WIN32
     log_info("Yakety is running. Press and hold Right Ctrl to record.");
 #else
     log_info("Yakety is running. Press and hold FN to record.");
 #endif
 
-    // Step 5: Handle first run dialog
+    // Step 7: Handle first run dialog
     handle_first_run();
 
-    log_info("App initialization completed successfully");
+    log_info("App initialization completed successfully (cold start took %.0f ms)", utils_now() * 1000.0);
+    if (g_memory_stats) {
+        log_memory_stats("after startup");
+    }
 }
 
 static const char *parse_cli_args(int argc, char **argv) {
@@ -265,14 +575,21 @@ static const char *parse_cli_args(int argc, char **argv) {
 
     // Check for help
     if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
-        printf("Usage: %s [model_path | --model <path>]\n", argv[0]);
+        printf("Usage: %s [model_path | --model <path>] [--stats]\n", argv[0]);
         printf("Options:\n");
         printf("  model_path        Direct path to Whisper model file\n");
         printf("  --model <path>    Use a specific Whisper model file\n");
+        printf("  --stats           Log memory use after loading and after every transcription\n");
         printf("  -h, --help        Show this help message\n");
         exit(0);
     }
 
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            g_memory_stats = true;
+        }
+    }
+
     // Check for --model flag
     for (int i = 1; i < argc - 1; i++) {
         if (strcmp(argv[i], "--model") == 0) {
@@ -291,13 +608,47 @@ static const char *parse_cli_args(int argc, char **argv) {
 // Cleanup all modules in proper order
 static void cleanup_all(void) {
     keylogger_cleanup();
+    cancel_transcriptions(); // Don't wait for inference on quit
+    if (g_state) {
+        streaming_cancel(g_state->stream);
+        mel_session_cancel(g_state->mel);
+        g_state->stream = NULL;
+        g_state->mel = NULL;
+    }
+    transcription_queue_cleanup();
+    if (trace_is_enabled()) {
+        trace_dump(trace_default_path());
+    }
+    metrics_cleanup();
+    if (g_cancel_mutex) {
+        utils_mutex_destroy(g_cancel_mutex);
+        g_cancel_mutex = NULL;
+    }
     if (!app_is_console()) {
         menu_cleanup();
     }
+    finish_audio_init(); // Quit before on_app_ready
     audio_recorder_cleanup();
+
+    TranscriptionSkipStats skip_stats;
+    transcription_get_skip_stats(&skip_stats);
+    log_info("📊 Transcriptions: %d inferred, %d cancelled, skipped %d too short, %d silent, %d without speech",
+             skip_stats.inferences, skip_stats.cancelled, skip_stats.skipped_too_short, skip_stats.skipped_silent,
+             skip_stats.skipped_no_speech);
+    TranscriptionTimingStats timing_stats;
+    transcription_get_timing_stats(&timing_stats);
+    if (timing_stats.runs > 0) {
+        const TranscriptionTimings *sum = &timing_stats.sum;
+        double runs = timing_stats.runs;
+        log_info("📊 Average per inference: mel %.0f ms, encode %.0f ms, decode %.0f ms, %.1f tokens",
+                 sum->mel_ms / runs, sum->encode_ms / runs, sum->decode_ms / runs, sum->n_sampled_tokens / runs);
+    }
     transcription_cleanup();
+    vad_cleanup();
+    prefetch_cleanup();
     overlay_cleanup();
     app_cleanup();
+    trace_cleanup();
     preferences_cleanup();
     log_cleanup();
 }
@@ -329,13 +680,28 @@ int app_main(int argc, char **argv, bool is_console) {
         preferences_set_string("model", custom_model_path);
     }
 
+    // Warm the file cache with the models while the rest of the app starts
+    prefetch_start();
+
+    // The VAD and mel locks must exist before models_load_start loads the models on their own threads
+    vad_setup();
+    mel_setup();
+
     // Set up signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    // Open the audio device while the app initializes
+    g_audio_thread = utils_thread_create(init_audio_work, NULL);
+    if (!g_audio_thread) {
+        init_audio_work(NULL);
+    }
+
     // Initialize app
     if (app_init("Yakety", "1.0", is_console, on_app_ready) != 0) {
         fprintf(stderr, "Failed to initialize app\n");
+        finish_audio_init();
+        audio_recorder_cleanup();
         return 1;
     }
 
@@ -343,11 +709,15 @@ int app_main(int argc, char **argv, bool is_console) {
     log_info("Initializing overlay");
     overlay_init();
 
-    // Initialize audio recorder
-    if (!audio_recorder_init()) {
-        log_error("Failed to initialize audio recorder");
-        cleanup_all();
-        return 1;
+    if (preferences_get_bool("trace_enabled", false)) {
+        trace_init();
+    }
+    metrics_init();
+
+    // Transcription runs off the keylogger thread
+    g_cancel_mutex = utils_mutex_create();
+    if (!transcription_queue_init()) {
+        log_error("Failed to start transcription worker, transcribing on the keylogger thread instead");
     }
 
     AppState state = {0};
@@ -360,7 +730,10 @@ int app_main(int argc, char **argv, bool is_console) {
 
     // Cleanup
     cleanup_all();
-    return 0;
+    return g_startup_failed ? 1 : 0;
 }
 
+// Programs that drive app_main themselves (src/tests/scripted_input.h) define YAKETY_NO_ENTRY_POINT
+#ifndef YAKETY_NO_ENTRY_POINT
 APP_ENTRY_POINT
+#endif
@@ -0,0 +1,575 @@
+#include "mel.h"
+#include "audio.h"
+#include "logging.h"
+#include "utils.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MEL_USE_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MEL_USE_NEON
+#endif
+
+#define MEL_SAMPLE_RATE 16000
+#define MEL_N_FFT 400                      // 25 ms frames
+#define MEL_HOP 160                        // 10 ms hop
+#define MEL_HALF_WINDOW (MEL_N_FFT / 2)    // Frame i is centered on sample i * MEL_HOP
+#define MEL_N_BINS (MEL_N_FFT / 2 + 1)
+#define MEL_PAD_FRAMES 3000                // whisper appends 30 s of silence
+#define MEL_LEAF 25                        // 400 = 2^4 * 25, radix-2 down to 25-point DFTs
+#define MEL_MAX_BANDS 256
+#define MEL_PI 3.14159265358979323846
+
+// The first frame whose window lies entirely inside the recording (no reflection padding)
+#define MEL_FIRST_CACHED_FRAME ((MEL_HALF_WINDOW + MEL_HOP - 1) / MEL_HOP)
+
+#define MEL_POLL_MS 100
+#define MEL_READ_CHUNK MEL_SAMPLE_RATE
+
+#define GGML_FILE_MAGIC 0x67676d6c
+#define WHISPER_HPARAM_COUNT 11
+
+// Filterbank read from the model file, shared by the sessions and caches computed with it
+typedef struct {
+    int refs; // Guarded by g_mel_mutex
+    int n_mel;
+    float *filters; // [n_mel][MEL_N_BINS]
+    int *first_tap; // Non-zero range of each filter, most taps are zero
+    int *end_tap;
+} MelFilterbank;
+
+struct MelSession {
+    utils_thread_t *thread;
+    bool running; // Atomic access required
+    MelFilterbank *filterbank;
+
+    // Recording pulled so far
+    float *audio;
+    int n_audio;
+    int audio_capacity;
+
+    // Raw log-mel frames [n_frames][n_mel], starting at MEL_FIRST_CACHED_FRAME
+    float *frames;
+    int n_frames;
+    int frames_capacity;
+};
+
+struct MelCache {
+    MelFilterbank *filterbank;
+    const float *samples;
+    int n_samples;
+    float *frames;
+    int n_frames;
+};
+
+// Tables shared by all filterbanks, same values whisper.cpp uses
+static float g_hann[MEL_N_FFT];
+static float g_cos[MEL_N_FFT];
+static float g_sin[MEL_N_FFT];
+static float g_dft_cos[MEL_LEAF * MEL_LEAF];
+static float g_dft_sin[MEL_LEAF * MEL_LEAF];
+static bool g_tables_ready = false;
+
+static MelFilterbank *g_filterbank = NULL;
+static utils_mutex_t *g_mel_mutex = NULL;
+
+static void init_tables(void) {
+    if (g_tables_ready) {
+        return;
+    }
+
+    for (int i = 0; i < MEL_N_FFT; i++) {
+        g_hann[i] = (float) (0.5 * (1.0 - cos((2.0 * MEL_PI * i) / MEL_N_FFT)));
+        double theta = (2.0 * MEL_PI * i) / MEL_N_FFT;
+        g_cos[i] = cosf((float) theta);
+        g_sin[i] = sinf((float) theta);
+    }
+
+    const int step = MEL_N_FFT / MEL_LEAF;
+    for (int k = 0; k < MEL_LEAF; k++) {
+        for (int n = 0; n < MEL_LEAF; n++) {
+            int idx = (k * n * step) % MEL_N_FFT;
+            g_dft_cos[k * MEL_LEAF + n] = g_cos[idx];
+            g_dft_sin[k * MEL_LEAF + n] = g_sin[idx];
+        }
+    }
+    g_tables_ready = true;
+}
+
+static void release_filterbank(MelFilterbank *filterbank) {
+    if (!filterbank) {
+        return;
+    }
+
+    utils_mutex_lock(g_mel_mutex);
+    bool last = --filterbank->refs == 0;
+    utils_mutex_unlock(g_mel_mutex);
+
+    if (last) {
+        free(filterbank->filters);
+        free(filterbank->first_tap);
+        free(filterbank->end_tap);
+        free(filterbank);
+    }
+}
+
+// The filterbank follows the hyperparameters at the start of a ggml whisper model file
+static MelFilterbank *load_filterbank(const char *model_path) {
+    FILE *file = utils_fopen_read_binary(model_path);
+    if (!file) {
+        return NULL;
+    }
+
+    uint32_t magic = 0;
+    int32_t hparams[WHISPER_HPARAM_COUNT];
+    int32_t n_mel = 0;
+    int32_t n_fft = 0;
+    if (fread(&magic, 4, 1, file) != 1 || magic != GGML_FILE_MAGIC ||
+        fread(hparams, 4, WHISPER_HPARAM_COUNT, file) != WHISPER_HPARAM_COUNT || fread(&n_mel, 4, 1, file) != 1 ||
+        fread(&n_fft, 4, 1, file) != 1 || n_fft != MEL_N_BINS || n_mel <= 0 || n_mel > MEL_MAX_BANDS) {
+        fclose(file);
+        return NULL;
+    }
+
+    MelFilterbank *filterbank = (MelFilterbank *) calloc(1, sizeof(MelFilterbank));
+    if (!filterbank) {
+        fclose(file);
+        return NULL;
+    }
+    filterbank->refs = 1;
+    filterbank->n_mel = n_mel;
+    filterbank->filters = (float *) malloc((size_t) n_mel * MEL_N_BINS * sizeof(float));
+    filterbank->first_tap = (int *) malloc((size_t) n_mel * sizeof(int));
+    filterbank->end_tap = (int *) malloc((size_t) n_mel * sizeof(int));
+    bool ok = filterbank->filters && filterbank->first_tap && filterbank->end_tap &&
+              fread(filterbank->filters, sizeof(float), (size_t) n_mel * MEL_N_BINS, file) ==
+                  (size_t) n_mel * MEL_N_BINS;
+    fclose(file);
+
+    if (!ok) {
+        free(filterbank->filters);
+        free(filterbank->first_tap);
+        free(filterbank->end_tap);
+        free(filterbank);
+        return NULL;
+    }
+
+    for (int m = 0; m < n_mel; m++) {
+        const float *filter = filterbank->filters + m * MEL_N_BINS;
+        int first = 0;
+        int end = MEL_N_BINS;
+        while (first < end && filter[first] == 0.0f) {
+            first++;
+        }
+        while (end > first && filter[end - 1] == 0.0f) {
+            end--;
+        }
+        filterbank->first_tap[m] = first;
+        filterbank->end_tap[m] = end;
+    }
+    return filterbank;
+}
+
+void mel_setup(void) {
+    if (!g_mel_mutex) {
+        g_mel_mutex = utils_mutex_create();
+    }
+}
+
+bool mel_init(const char *model_path) {
+    if (!model_path || !g_mel_mutex) {
+        return false;
+    }
+    init_tables();
+
+    MelFilterbank *filterbank = load_filterbank(model_path);
+    if (!filterbank) {
+        log_error("Could not read mel filterbank from %s, incremental mel disabled", model_path);
+        return false;
+    }
+
+    utils_mutex_lock(g_mel_mutex);
+    MelFilterbank *old = g_filterbank;
+    g_filterbank = filterbank;
+    utils_mutex_unlock(g_mel_mutex);
+    release_filterbank(old);
+
+    log_info("🎛️  Mel filterbank loaded (%d bands)", filterbank->n_mel);
+    return true;
+}
+
+void mel_cleanup(void) {
+    if (!g_mel_mutex) {
+        return;
+    }
+
+    utils_mutex_lock(g_mel_mutex);
+    MelFilterbank *old = g_filterbank;
+    g_filterbank = NULL;
+    utils_mutex_unlock(g_mel_mutex);
+    release_filterbank(old);
+}
+
+static float dot_product(const float *a, const float *b, int count) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(MEL_USE_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(MEL_USE_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    sum = vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) + vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#endif
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// 25-point DFT of real input as table-driven dot products, interleaved complex output
+static void dft_leaf(const float *in, float *out) {
+    for (int k = 0; k < MEL_LEAF; k++) {
+        out[2 * k] = dot_product(in, g_dft_cos + k * MEL_LEAF, MEL_LEAF);
+        out[2 * k + 1] = -dot_product(in, g_dft_sin + k * MEL_LEAF, MEL_LEAF);
+    }
+}
+
+// Radix-2 FFT with the same recursion and scratch layout as whisper.cpp: in needs 2n floats, out 8n
+static void fft(float *in, int n, float *out) {
+    if (n == MEL_LEAF) {
+        dft_leaf(in, out);
+        return;
+    }
+
+    const int half = n / 2;
+    float *even = in + n;
+    for (int i = 0; i < half; i++) {
+        even[i] = in[2 * i];
+    }
+    float *even_fft = out + 2 * n;
+    fft(even, half, even_fft);
+
+    float *odd = even;
+    for (int i = 0; i < half; i++) {
+        odd[i] = in[2 * i + 1];
+    }
+    float *odd_fft = even_fft + n;
+    fft(odd, half, odd_fft);
+
+    const int step = MEL_N_FFT / n;
+    for (int k = 0; k < half; k++) {
+        float re = g_cos[k * step];
+        float im = -g_sin[k * step];
+        float re_odd = odd_fft[2 * k];
+        float im_odd = odd_fft[2 * k + 1];
+
+        out[2 * k] = even_fft[2 * k] + re * re_odd - im * im_odd;
+        out[2 * k + 1] = even_fft[2 * k + 1] + re * im_odd + im * re_odd;
+        out[2 * (k + half)] = even_fft[2 * k] - re * re_odd + im * im_odd;
+        out[2 * (k + half) + 1] = even_fft[2 * k + 1] - re * im_odd - im * re_odd;
+    }
+}
+
+// Raw log-mel of one 400-sample window (before whisper's normalization)
+static void compute_frame(const MelFilterbank *filterbank, const float *window, float *out) {
+    float fft_in[MEL_N_FFT * 2];
+    float fft_out[MEL_N_FFT * 8];
+
+    for (int i = 0; i < MEL_N_FFT; i++) {
+        fft_in[i] = g_hann[i] * window[i];
+    }
+    fft(fft_in, MEL_N_FFT, fft_out);
+
+    for (int k = 0; k < MEL_N_BINS; k++) {
+        fft_out[k] = fft_out[2 * k] * fft_out[2 * k] + fft_out[2 * k + 1] * fft_out[2 * k + 1];
+    }
+
+    for (int m = 0; m < filterbank->n_mel; m++) {
+        const float *filter = filterbank->filters + m * MEL_N_BINS;
+        double sum = 0.0;
+        for (int k = filterbank->first_tap[m]; k < filterbank->end_tap[m]; k++) {
+            sum += fft_out[k] * filter[k];
+        }
+        out[m] = (float) log10(sum > 1e-10 ? sum : 1e-10);
+    }
+}
+
+static bool grow_floats(float **buffer, int *capacity, int needed) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    int new_capacity = *capacity * 2 > needed ? *capacity * 2 : needed;
+    float *new_buffer = (float *) realloc(*buffer, (size_t) new_capacity * sizeof(float));
+    if (!new_buffer) {
+        return false;
+    }
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+    return true;
+}
+
+// Pull everything recorded since the last call and compute every frame whose window is complete
+static void session_update(MelSession *session) {
+    for (;;) {
+        if (!grow_floats(&session->audio, &session->audio_capacity, session->n_audio + MEL_READ_CHUNK)) {
+            log_error("Mel: failed to grow audio buffer");
+            return;
+        }
+        int count = audio_recorder_read_samples(session->n_audio, session->audio + session->n_audio, MEL_READ_CHUNK);
+        session->n_audio += count;
+        if (count < MEL_READ_CHUNK) {
+            break;
+        }
+    }
+
+    const int n_mel = session->filterbank->n_mel;
+    for (;;) {
+        int frame = MEL_FIRST_CACHED_FRAME + session->n_frames;
+        if (frame * MEL_HOP + MEL_HALF_WINDOW > session->n_audio) {
+            return;
+        }
+        if (!grow_floats(&session->frames, &session->frames_capacity, (session->n_frames + 1) * n_mel)) {
+            log_error("Mel: failed to grow frame buffer");
+            return;
+        }
+        compute_frame(session->filterbank, session->audio + frame * MEL_HOP - MEL_HALF_WINDOW,
+                      session->frames + session->n_frames * n_mel);
+        session->n_frames++;
+    }
+}
+
+static void *mel_worker(void *arg) {
+    MelSession *session = (MelSession *) arg;
+
+    while (utils_atomic_read_bool(&session->running)) {
+        utils_sleep_ms(MEL_POLL_MS);
+        session_update(session);
+    }
+    return NULL;
+}
+
+static void free_session(MelSession *session) {
+    release_filterbank(session->filterbank);
+    free(session->audio);
+    free(session->frames);
+    free(session);
+}
+
+MelSession *mel_session_start(void) {
+    if (!g_mel_mutex) {
+        return NULL;
+    }
+
+    // Retain in the same critical section, mel_init may replace and release it right after
+    utils_mutex_lock(g_mel_mutex);
+    MelFilterbank *filterbank = g_filterbank;
+    if (filterbank) {
+        filterbank->refs++;
+    }
+    utils_mutex_unlock(g_mel_mutex);
+    if (!filterbank) {
+        return NULL;
+    }
+
+    MelSession *session = (MelSession *) calloc(1, sizeof(MelSession));
+    if (!session) {
+        release_filterbank(filterbank);
+        return NULL;
+    }
+    session->filterbank = filterbank;
+
+    utils_atomic_write_bool(&session->running, true);
+    session->thread = utils_thread_create(mel_worker, session);
+    if (!session->thread) {
+        log_error("Failed to start incremental mel worker");
+        free_session(session);
+        return NULL;
+    }
+    return session;
+}
+
+void mel_session_stop(MelSession *session) {
+    if (session) {
+        utils_atomic_write_bool(&session->running, false);
+    }
+}
+
+static void join_worker(MelSession *session) {
+    mel_session_stop(session);
+    if (session->thread) {
+        utils_thread_join(session->thread);
+        session->thread = NULL;
+    }
+}
+
+MelCache *mel_session_finish(MelSession *session, const float *samples, int n_samples) {
+    if (!session) {
+        return NULL;
+    }
+    join_worker(session);
+
+    // The worker may have pulled audio of the next recording after release, only keep
+    // frames computed from audio that matches the final recording
+    int valid = session->n_audio < n_samples ? session->n_audio : n_samples;
+    if (valid > 0 && memcmp(session->audio, samples, (size_t) valid * sizeof(float)) != 0) {
+        int i = 0;
+        while (i < valid && memcmp(&session->audio[i], &samples[i], sizeof(float)) == 0) {
+            i++;
+        }
+        valid = i;
+    }
+    int n_frames = (valid - MEL_HALF_WINDOW) / MEL_HOP - MEL_FIRST_CACHED_FRAME + 1;
+    if (n_frames < 0) {
+        n_frames = 0;
+    }
+    if (n_frames > session->n_frames) {
+        n_frames = session->n_frames;
+    }
+
+    MelCache *cache = (MelCache *) calloc(1, sizeof(MelCache));
+    if (!cache) {
+        free_session(session);
+        return NULL;
+    }
+    cache->filterbank = session->filterbank;
+    cache->samples = samples;
+    cache->n_samples = n_samples;
+    cache->frames = session->frames;
+    cache->n_frames = n_frames;
+
+    session->filterbank = NULL;
+    session->frames = NULL;
+    free_session(session);
+    return cache;
+}
+
+void mel_session_cancel(MelSession *session) {
+    if (session) {
+        join_worker(session);
+        free_session(session);
+    }
+}
+
+void mel_cache_free(MelCache *cache) {
+    if (cache) {
+        release_filterbank(cache->filterbank);
+        free(cache->frames);
+        free(cache);
+    }
+}
+
+int mel_cache_source_offset(const MelCache *cache, const float *audio, int n_samples) {
+    if (!cache || !audio || audio < cache->samples || audio + n_samples > cache->samples + cache->n_samples) {
+        return -1;
+    }
+    return (int) (audio - cache->samples);
+}
+
+// Sample of the audio as whisper pads it: reflected at the start, silence after the end
+static float padded_sample(const float *audio, int n_samples, int index) {
+    if (index < 0) {
+        index = -index;
+    }
+    return index < n_samples ? audio[index] : 0.0f;
+}
+
+float *mel_build(const MelCache *cache, const float *audio, int n_samples, const MelPiece *pieces, int n_pieces,
+                 int n_mel, int *n_len, int *n_reused) {
+    if (!cache || cache->filterbank->n_mel != n_mel || n_samples <= 0) {
+        return NULL;
+    }
+
+    const int len = n_samples / MEL_HOP + MEL_PAD_FRAMES;
+    int fft_frames = (n_samples + MEL_HALF_WINDOW) / MEL_HOP + 1; // Later frames only see silence
+    if (fft_frames > len) {
+        fft_frames = len;
+    }
+
+    float *mel = (float *) malloc((size_t) n_mel * len * sizeof(float));
+    float *frame = (float *) malloc((size_t) n_mel * sizeof(float));
+    float *silence = (float *) malloc((size_t) n_mel * sizeof(float));
+    if (!mel || !frame || !silence) {
+        free(mel);
+        free(frame);
+        free(silence);
+        return NULL;
+    }
+    for (int m = 0; m < n_mel; m++) {
+        silence[m] = -10.0f; // log10(1e-10) of an all-zero frame
+    }
+
+    float window[MEL_N_FFT];
+    int piece = 0;
+    int reused = 0;
+    for (int i = 0; i < len; i++) {
+        const float *values = silence;
+
+        if (i < fft_frames) {
+            int begin = i * MEL_HOP - MEL_HALF_WINDOW;
+            int end = begin + MEL_N_FFT;
+            while (piece < n_pieces && pieces[piece].offset + pieces[piece].length <= begin) {
+                piece++;
+            }
+            const MelPiece *p = piece < n_pieces ? &pieces[piece] : NULL;
+            bool inside = p && begin >= p->offset && end <= p->offset + p->length;
+
+            if (inside && p->source < 0) {
+                values = silence;
+            } else {
+                int center = inside ? i * MEL_HOP - p->offset + p->source : -1;
+                int cached = center >= 0 && center % MEL_HOP == 0 ? center / MEL_HOP - MEL_FIRST_CACHED_FRAME : -1;
+                if (cached >= 0 && cached < cache->n_frames) {
+                    values = cache->frames + cached * n_mel;
+                    reused++;
+                } else {
+                    for (int k = 0; k < MEL_N_FFT; k++) {
+                        window[k] = padded_sample(audio, n_samples, begin + k);
+                    }
+                    compute_frame(cache->filterbank, window, frame);
+                    values = frame;
+                }
+            }
+        }
+
+        for (int m = 0; m < n_mel; m++) {
+            mel[m * len + i] = values[m];
+        }
+    }
+
+    // Same normalization as whisper: clamp to 8 below the maximum (log10 units) and rescale
+    double mmax = -1e20;
+    for (int i = 0; i < n_mel * len; i++) {
+        if (mel[i] > mmax) {
+            mmax = mel[i];
+        }
+    }
+    mmax -= 8.0;
+    for (int i = 0; i < n_mel * len; i++) {
+        if (mel[i] < mmax) {
+            mel[i] = (float) mmax;
+        }
+        mel[i] = (mel[i] + 4.0f) / 4.0f;
+    }
+
+    free(frame);
+    free(silence);
+    *n_len = len;
+    if (n_reused) {
+        *n_reused = reused;
+    }
+    return mel;
+}
@@ -0,0 +1,55 @@
+#ifndef MEL_H
+#define MEL_H
+
+#include <stdbool.h>
+
+// Incremental log-mel spectrogram, computed from the capture stream while the hotkey is held so
+// only encode/decode is left after release. Matches whisper.cpp's log_mel_spectrogram: 25 ms Hann
+// frames every 10 ms, the model's own filterbank, 30 s of silence padding and the same normalization.
+
+typedef struct MelSession MelSession;
+typedef struct MelCache MelCache;
+
+// Create the lock guarding the filterbank. Call once from the main thread before any thread loads
+// a model or starts a session. Without it mel_init does nothing and there are no sessions, which
+// suits tools that never record.
+void mel_setup(void);
+
+// Load the mel filterbank stored in a ggml whisper model file, used by sessions started afterwards
+bool mel_init(const char *model_path);
+void mel_cleanup(void);
+
+// Start computing frames of the current memory recording. Call right after audio_recorder_start().
+// Returns NULL if no filterbank is loaded or the worker could not be started.
+MelSession *mel_session_start(void);
+
+// Stop pulling audio from the recorder. Non-blocking, call on release before audio_recorder_stop().
+void mel_session_stop(MelSession *session);
+
+// Finish the session against the complete recording (as returned by audio_recorder_get_samples()).
+// The cache refers to samples, which must outlive it. Frees the session; returns NULL if session is NULL.
+MelCache *mel_session_finish(MelSession *session, const float *samples, int n_samples);
+
+// Abort the session and free it
+void mel_session_cancel(MelSession *session);
+
+void mel_cache_free(MelCache *cache);
+
+// Offset of audio within the cached recording, or -1 if audio doesn't point into it
+int mel_cache_source_offset(const MelCache *cache, const float *audio, int n_samples);
+
+// A run of the audio given to mel_build(): length samples at offset, copied from the cached
+// recording starting at source, or silence if source is -1
+typedef struct {
+    int offset;
+    int length;
+    int source;
+} MelPiece;
+
+// Build whisper's normalized log-mel spectrogram ([n_mel][n_len], malloc'd) for audio made of pieces
+// of the cached recording. Cached frames are reused, frames across piece edges are computed from audio.
+// Returns NULL if the cache was computed for a different number of mel bands.
+float *mel_build(const MelCache *cache, const float *audio, int n_samples, const MelPiece *pieces, int n_pieces,
+                 int n_mel, int *n_len, int *n_reused);
+
+#endif // MEL_H
@@ -11,6 +11,7 @@
 #include "models.h"
 #include "overlay.h"
 #include "preferences.h"
+#include "trace.h"
 #include "transcription.h"
 #include "utils.h"
 
@@ -96,18 +97,8 @@ static void menu_models(void) {
     preferences_set_string("language", selected_language);
     preferences_save();
 
-    // Pause keylogger during reload
-    keylogger_pause();
-
-    // Load the model using THE ONE function
-    int result = models_load();
-
-    // Resume keylogger
-    keylogger_resume();
-
-    if (result != 0) {
-        log_error("Failed to load model after settings change");
-    }
+    // Load in the background, dictation keeps using the current model until the new one is ready
+    models_reload();
 }
 
 static void menu_configure_hotkey(void) {
@@ -158,18 +149,19 @@ static void menu_toggle_vad(void) {
         menu_update_item(g_vad_menu_index, new_label);
     }
     
-    // Pause keylogger during reload
-    keylogger_pause();
-    
-    // Reload the model with new VAD setting
-    int result = models_load();
-    
-    // Resume keylogger
-    keylogger_resume();
-    
-    if (result != 0) {
-        log_error("Failed to reload model after VAD setting change");
-        dialog_error("VAD Settings", "Failed to reload model with new VAD setting.");
+    // Load or unload the VAD model in the background
+    models_reload();
+}
+
+static void menu_save_trace(void) {
+    const char *path = trace_default_path();
+    if (path && trace_dump(path)) {
+        char message[1200];
+        snprintf(message, sizeof(message), "Latency trace saved to:\n%s\n\nOpen it in chrome://tracing or ui.perfetto.dev.",
+                 path);
+        dialog_info("Latency Trace", message);
+    } else {
+        dialog_error("Latency Trace", "Failed to save the latency trace.");
     }
 }
 
@@ -200,6 +192,10 @@ int menu_setup_items(MenuSystem *menu) {
         utils_is_launch_at_login_enabled() ? "Disable Launch at Login" : "Enable Launch at Login";
     g_launch_menu_index = menu_add_item(menu, launch_label, menu_toggle_launch_at_login);
 
+    if (trace_is_enabled()) {
+        menu_add_item(menu, "Save Latency Trace", menu_save_trace);
+    }
+
     menu_add_separator(menu);
     menu_add_item(menu, "Quit", menu_quit);
 
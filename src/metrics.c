@@ -0,0 +1,544 @@
+#include "metrics.h"
+#include "logging.h"
+#include "preferences.h"
+#include "utils.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// HDR layout: values below 2 * HDR_SUB_BUCKETS are counted exactly, every power of two above
+// is split into HDR_SUB_BUCKETS linear sub-buckets, so any value is off by less than 1/128
+#define HDR_SUB_BUCKET_BITS 7
+#define HDR_SUB_BUCKETS (1 << HDR_SUB_BUCKET_BITS)
+#define HDR_MAX_EXPONENT 40 // Values are clamped to 2^41 - 1 (25 days in microseconds)
+#define HDR_COUNTS (2 * HDR_SUB_BUCKETS + (HDR_MAX_EXPONENT - HDR_SUB_BUCKET_BITS) * HDR_SUB_BUCKETS)
+
+#define METRICS_STATE_FILE "metrics-histograms.txt"
+#define METRICS_EXPORT_FILE "metrics.prom"
+#define METRICS_STATE_VERSION 1
+#define METRICS_SOCKET_POLL_MS 200
+
+typedef struct {
+    const char *key;  // Persistence key
+    const char *name; // Prometheus metric name
+    const char *help;
+    double scale; // Recorded value * scale = histogram value
+} MetricInfo;
+
+static const MetricInfo METRICS[METRIC_COUNT] = {
+    {"stop_to_paste", "yakety_stop_to_paste_seconds", "Time from key release until the text is pasted", 1e6},
+    {"inference", "yakety_inference_seconds", "Time spent transcribing a clip", 1e6},
+    {"rtf", "yakety_real_time_factor", "Inference time divided by audio duration", 1e4},
+};
+
+// Recording length buckets, upper bounds in seconds
+static const struct {
+    const char *label;
+    double max_seconds;
+} CLIP_BUCKETS[] = {
+    {"0-2s", 2.0}, {"2-5s", 5.0}, {"5-10s", 10.0}, {"10-30s", 30.0}, {"30s+", 1e9},
+};
+#define CLIP_BUCKET_COUNT ((int) (sizeof(CLIP_BUCKETS) / sizeof(CLIP_BUCKETS[0])))
+
+static const double QUANTILES[] = {0.5, 0.95, 0.99};
+
+typedef struct MetricHistogram {
+    struct MetricHistogram *next;
+    int metric;
+    int clip_bucket;
+    char model[64];
+    uint64_t total;
+    double sum; // Of recorded values, unscaled
+    uint64_t counts[HDR_COUNTS];
+} MetricHistogram;
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} TextBuffer;
+
+typedef struct {
+    utils_mutex_t *mutex; // Guards everything below
+    MetricHistogram *histograms;
+    char model[64];
+    char state_path[1024];
+    char export_path[1024];
+
+#ifndef _WIN32
+    int socket_fd;
+    char socket_path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+    utils_thread_t *socket_thread;
+    bool socket_running; // Atomic access required
+#endif
+} Metrics;
+
+// Global singleton instance
+static Metrics *g_metrics = NULL;
+
+static int highest_bit(uint64_t value) {
+    int bit = 0;
+    while (value >> (bit + 1)) {
+        bit++;
+    }
+    return bit;
+}
+
+static int hdr_index(uint64_t value) {
+    if (value < 2 * HDR_SUB_BUCKETS) {
+        return (int) value;
+    }
+    int exponent = highest_bit(value);
+    if (exponent > HDR_MAX_EXPONENT) {
+        return HDR_COUNTS - 1;
+    }
+    int shift = exponent - HDR_SUB_BUCKET_BITS;
+    return 2 * HDR_SUB_BUCKETS + (shift - 1) * HDR_SUB_BUCKETS + (int) ((value >> shift) - HDR_SUB_BUCKETS);
+}
+
+// Largest value counted at index
+static uint64_t hdr_value(int index) {
+    if (index < 2 * HDR_SUB_BUCKETS) {
+        return (uint64_t) index;
+    }
+    int shift = (index - 2 * HDR_SUB_BUCKETS) / HDR_SUB_BUCKETS + 1;
+    uint64_t sub = (uint64_t) ((index - 2 * HDR_SUB_BUCKETS) % HDR_SUB_BUCKETS + HDR_SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+static uint64_t hdr_quantile(const MetricHistogram *histogram, double quantile) {
+    uint64_t rank = (uint64_t) (quantile * (double) histogram->total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HDR_COUNTS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            return hdr_value(i);
+        }
+    }
+    return 0;
+}
+
+static int clip_bucket(double clip_seconds) {
+    for (int i = 0; i < CLIP_BUCKET_COUNT - 1; i++) {
+        if (clip_seconds < CLIP_BUCKETS[i].max_seconds) {
+            return i;
+        }
+    }
+    return CLIP_BUCKET_COUNT - 1;
+}
+
+static MetricHistogram *find_histogram(int metric, int bucket, const char *model, bool create) {
+    for (MetricHistogram *h = g_metrics->histograms; h; h = h->next) {
+        if (h->metric == metric && h->clip_bucket == bucket && strcmp(h->model, model) == 0) {
+            return h;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    MetricHistogram *histogram = (MetricHistogram *) calloc(1, sizeof(MetricHistogram));
+    if (!histogram) {
+        return NULL;
+    }
+    histogram->metric = metric;
+    histogram->clip_bucket = bucket;
+    strncpy(histogram->model, model, sizeof(histogram->model) - 1);
+    histogram->next = g_metrics->histograms;
+    g_metrics->histograms = histogram;
+    return histogram;
+}
+
+static void build_path(char *path, size_t size, const char *dir, const char *file) {
+    snprintf(path, size, "%s%c%s", dir,
+#ifdef _WIN32
+             '\\',
+#else
+             '/',
+#endif
+             file);
+}
+
+// Replace the file at path with data, readers never see a partial file
+static bool write_file_atomic(const char *path, const char *data, size_t len) {
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *file = utils_fopen_write(tmp_path);
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, file) == len;
+    ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+    remove(path); // rename() doesn't replace on Windows
+#endif
+    if (!ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+static void text_append(TextBuffer *buffer, const char *format, ...) {
+    for (;;) {
+        size_t available = buffer->capacity - buffer->len;
+        va_list args;
+        va_start(args, format);
+        int written = buffer->data ? vsnprintf(buffer->data + buffer->len, available, format, args) : -1;
+        va_end(args);
+
+        if (written >= 0 && (size_t) written < available) {
+            buffer->len += (size_t) written;
+            return;
+        }
+        if (written < 0 && buffer->data) {
+            return; // Encoding error
+        }
+
+        size_t needed = buffer->len + (written > 0 ? (size_t) written : 0) + 1;
+        size_t new_capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        char *new_data = (char *) realloc(buffer->data, new_capacity);
+        if (!new_data) {
+            return;
+        }
+        buffer->data = new_data;
+        buffer->capacity = new_capacity;
+    }
+}
+
+// Prometheus text exposition, one summary per metric with a series per model and clip bucket
+static void render_prometheus(TextBuffer *out) {
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        const MetricInfo *info = &METRICS[metric];
+        text_append(out, "# HELP %s %s\n# TYPE %s summary\n", info->name, info->help, info->name);
+        for (MetricHistogram *h = g_metrics->histograms; h; h = h->next) {
+            if (h->metric != metric || h->total == 0) {
+                continue;
+            }
+            const char *clip = CLIP_BUCKETS[h->clip_bucket].label;
+            for (size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); q++) {
+                text_append(out, "%s{model=\"%s\",clip=\"%s\",quantile=\"%g\"} %.6g\n", info->name, h->model, clip,
+                            QUANTILES[q], (double) hdr_quantile(h, QUANTILES[q]) / info->scale);
+            }
+            text_append(out, "%s_sum{model=\"%s\",clip=\"%s\"} %.6g\n", info->name, h->model, clip, h->sum);
+            text_append(out, "%s_count{model=\"%s\",clip=\"%s\"} %llu\n", info->name, h->model, clip,
+                        (unsigned long long) h->total);
+        }
+    }
+}
+
+static void render_state(TextBuffer *out) {
+    text_append(out, "yakety-metrics %d\n", METRICS_STATE_VERSION);
+    for (MetricHistogram *h = g_metrics->histograms; h; h = h->next) {
+        text_append(out, "histogram %s %s %s %llu %.17g\n", METRICS[h->metric].key, h->model,
+                    CLIP_BUCKETS[h->clip_bucket].label, (unsigned long long) h->total, h->sum);
+        for (int i = 0; i < HDR_COUNTS; i++) {
+            if (h->counts[i] > 0) {
+                text_append(out, "%d %llu\n", i, (unsigned long long) h->counts[i]);
+            }
+        }
+        text_append(out, "end\n");
+    }
+}
+
+static int find_metric(const char *key) {
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        if (strcmp(METRICS[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_clip_bucket(const char *label) {
+    for (int i = 0; i < CLIP_BUCKET_COUNT; i++) {
+        if (strcmp(CLIP_BUCKETS[i].label, label) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void load_state(void) {
+    FILE *file = utils_fopen_read(g_metrics->state_path);
+    if (!file) {
+        return; // First run
+    }
+
+    int version = 0;
+    if (fscanf(file, "yakety-metrics %d", &version) != 1 || version != METRICS_STATE_VERSION) {
+        log_error("Ignoring metrics state with unknown format: %s", g_metrics->state_path);
+        fclose(file);
+        return;
+    }
+
+    int loaded = 0;
+    char key[32], model[64], clip[16];
+    unsigned long long total;
+    double sum;
+    while (fscanf(file, " histogram %31s %63s %15s %llu %lf", key, model, clip, &total, &sum) == 5) {
+        int metric = find_metric(key);
+        int bucket = find_clip_bucket(clip);
+        MetricHistogram *h = metric >= 0 && bucket >= 0 ? find_histogram(metric, bucket, model, true) : NULL;
+        if (h) {
+            h->total = total;
+            h->sum = sum;
+            loaded++;
+        }
+
+        int index;
+        unsigned long long count;
+        while (fscanf(file, " %d %llu", &index, &count) == 2) {
+            if (h && index >= 0 && index < HDR_COUNTS) {
+                h->counts[index] = count;
+            }
+        }
+        char end[4];
+        if (fscanf(file, " %3s", end) != 1 || strcmp(end, "end") != 0) {
+            break;
+        }
+    }
+    fclose(file);
+    log_info("📊 Loaded %d latency histograms from %s", loaded, g_metrics->state_path);
+}
+
+#ifndef _WIN32
+// Serves the Prometheus exposition as a minimal HTTP response to every client, so it can be
+// scraped with e.g. curl --unix-socket
+static void *socket_worker(void *arg) {
+    (void) arg;
+    while (utils_atomic_read_bool(&g_metrics->socket_running)) {
+        struct pollfd listener = {g_metrics->socket_fd, POLLIN, 0};
+        if (poll(&listener, 1, METRICS_SOCKET_POLL_MS) <= 0) {
+            continue;
+        }
+        int client = accept(g_metrics->socket_fd, NULL, NULL);
+        if (client < 0) {
+            continue;
+        }
+
+        // Drain the request if one arrives quickly, its content doesn't matter
+        struct pollfd request = {client, POLLIN, 0};
+        if (poll(&request, 1, 100) > 0) {
+            char discard[1024];
+            ssize_t ignored = read(client, discard, sizeof(discard));
+            (void) ignored;
+        }
+
+        TextBuffer body = {0};
+        utils_mutex_lock(g_metrics->mutex);
+        render_prometheus(&body);
+        utils_mutex_unlock(g_metrics->mutex);
+
+        char header[128];
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %zu\r\n\r\n",
+                                  body.len);
+        if (write(client, header, (size_t) header_len) == header_len && body.data) {
+            ssize_t ignored = write(client, body.data, body.len);
+            (void) ignored;
+        }
+        free(body.data);
+        close(client);
+    }
+    return NULL;
+}
+
+static void start_socket_exporter(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        log_error("Metrics socket path too long: %s", path);
+        return;
+    }
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        log_error("Failed to create metrics socket");
+        return;
+    }
+    unlink(path); // Left behind by a previous run
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(fd, 4) != 0) {
+        log_error("Failed to listen on metrics socket: %s", path);
+        close(fd);
+        return;
+    }
+
+    g_metrics->socket_fd = fd;
+    strncpy(g_metrics->socket_path, path, sizeof(g_metrics->socket_path) - 1);
+    utils_atomic_write_bool(&g_metrics->socket_running, true);
+    g_metrics->socket_thread = utils_thread_create(socket_worker, NULL);
+    if (!g_metrics->socket_thread) {
+        log_error("Failed to start metrics socket exporter");
+        utils_atomic_write_bool(&g_metrics->socket_running, false);
+        close(fd);
+        unlink(path);
+        g_metrics->socket_fd = -1;
+        return;
+    }
+    log_info("📊 Serving metrics on unix socket %s", path);
+}
+
+static void stop_socket_exporter(void) {
+    if (!g_metrics->socket_thread) {
+        return;
+    }
+    utils_atomic_write_bool(&g_metrics->socket_running, false);
+    utils_thread_join(g_metrics->socket_thread);
+    g_metrics->socket_thread = NULL;
+    close(g_metrics->socket_fd);
+    unlink(g_metrics->socket_path);
+    g_metrics->socket_fd = -1;
+}
+#endif
+
+bool metrics_init(void) {
+    if (g_metrics) {
+        return true;
+    }
+    if (!preferences_get_bool("metrics_enabled", true)) {
+        return false;
+    }
+
+    const char *dir = utils_get_config_dir();
+    if (!dir) {
+        log_error("Failed to get config directory for metrics");
+        return false;
+    }
+
+    g_metrics = (Metrics *) calloc(1, sizeof(Metrics));
+    if (!g_metrics) {
+        return false;
+    }
+    g_metrics->mutex = utils_mutex_create();
+    if (!g_metrics->mutex) {
+        free(g_metrics);
+        g_metrics = NULL;
+        return false;
+    }
+    strncpy(g_metrics->model, "unknown", sizeof(g_metrics->model) - 1);
+
+    utils_ensure_dir_exists(dir);
+    build_path(g_metrics->state_path, sizeof(g_metrics->state_path), dir, METRICS_STATE_FILE);
+    const char *export_path = preferences_get_string("metrics_export_path");
+    if (export_path && export_path[0]) {
+        strncpy(g_metrics->export_path, export_path, sizeof(g_metrics->export_path) - 1);
+    } else {
+        build_path(g_metrics->export_path, sizeof(g_metrics->export_path), dir, METRICS_EXPORT_FILE);
+    }
+
+    load_state();
+
+#ifndef _WIN32
+    g_metrics->socket_fd = -1;
+    const char *socket_path = preferences_get_string("metrics_socket");
+    if (socket_path && socket_path[0]) {
+        start_socket_exporter(socket_path);
+    }
+#endif
+    return true;
+}
+
+void metrics_cleanup(void) {
+    if (!g_metrics) {
+        return;
+    }
+#ifndef _WIN32
+    stop_socket_exporter();
+#endif
+    metrics_flush();
+
+    while (g_metrics->histograms) {
+        MetricHistogram *next = g_metrics->histograms->next;
+        free(g_metrics->histograms);
+        g_metrics->histograms = next;
+    }
+    utils_mutex_destroy(g_metrics->mutex);
+    free(g_metrics);
+    g_metrics = NULL;
+}
+
+void metrics_set_model(const char *model_path) {
+    if (!g_metrics || !model_path) {
+        return;
+    }
+
+    // File name without extension, label-safe
+    const char *name = strrchr(model_path, '/');
+    const char *backslash = strrchr(model_path, '\\');
+    if (backslash && (!name || backslash > name)) {
+        name = backslash;
+    }
+    name = name ? name + 1 : model_path;
+
+    utils_mutex_lock(g_metrics->mutex);
+    size_t len = 0;
+    for (; name[len] && len < sizeof(g_metrics->model) - 1; len++) {
+        char c = name[len];
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' ||
+                    c == '-' || c == '_';
+        g_metrics->model[len] = safe ? c : '_';
+    }
+    g_metrics->model[len] = '\0';
+    char *extension = strrchr(g_metrics->model, '.');
+    if (extension && strcmp(extension, ".bin") == 0) {
+        *extension = '\0';
+    }
+    utils_mutex_unlock(g_metrics->mutex);
+}
+
+void metrics_record(MetricId metric, double value, double clip_seconds) {
+    if (!g_metrics || metric < 0 || metric >= METRIC_COUNT || value < 0) {
+        return;
+    }
+
+    utils_mutex_lock(g_metrics->mutex);
+    MetricHistogram *histogram = find_histogram(metric, clip_bucket(clip_seconds), g_metrics->model, true);
+    if (histogram) {
+        histogram->counts[hdr_index((uint64_t) (value * METRICS[metric].scale + 0.5))]++;
+        histogram->total++;
+        histogram->sum += value;
+    }
+    utils_mutex_unlock(g_metrics->mutex);
+}
+
+void metrics_flush(void) {
+    if (!g_metrics) {
+        return;
+    }
+
+    TextBuffer state = {0};
+    TextBuffer exposition = {0};
+    utils_mutex_lock(g_metrics->mutex);
+    render_state(&state);
+    render_prometheus(&exposition);
+    utils_mutex_unlock(g_metrics->mutex);
+
+    if (state.data && !write_file_atomic(g_metrics->state_path, state.data, state.len)) {
+        log_error("Failed to save metrics to %s", g_metrics->state_path);
+    }
+    if (exposition.data && !write_file_atomic(g_metrics->export_path, exposition.data, exposition.len)) {
+        log_error("Failed to export metrics to %s", g_metrics->export_path);
+    }
+    free(state.data);
+    free(exposition.data);
+}
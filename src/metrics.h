@@ -0,0 +1,32 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+
+// Latency metrics - HDR histograms (about 1% precision over the full range) keyed by model and
+// clip length bucket. They persist across restarts in the config directory and are exported in
+// Prometheus text format: to a file (<config dir>/metrics.prom unless "metrics_export_path" is set)
+// and, on macOS and Linux, to clients of a Unix socket if "metrics_socket" is set.
+
+typedef enum {
+    METRIC_STOP_TO_PASTE, // Seconds from key release to paste
+    METRIC_INFERENCE,     // Seconds spent transcribing a clip
+    METRIC_RTF,           // Inference time divided by audio duration
+    METRIC_COUNT
+} MetricId;
+
+// Load persisted histograms and start the socket exporter. No-op if "metrics_enabled" is off.
+bool metrics_init(void);
+// Persist, export and stop the socket exporter
+void metrics_cleanup(void);
+
+// Model the following samples are attributed to, named after the model file
+void metrics_set_model(const char *model_path);
+
+// Record one sample for a clip of clip_seconds recorded audio
+void metrics_record(MetricId metric, double value, double clip_seconds);
+
+// Persist the histograms and rewrite the export file, call after a dictation
+void metrics_flush(void);
+
+#endif // METRICS_H
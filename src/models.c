@@ -1,14 +1,42 @@
 #include "models.h"
 #include "transcription.h"
+#include "vad.h"
 #include "preferences.h"
 #include "utils.h"
 #include "overlay.h"
 #include "logging.h"
+#include "metrics.h"
+#include "trace.h"
+#include "autotune.h"
 #include "dialog.h"
 #include "app.h"
 #include <stdio.h>
 #include <string.h>
 
+#define LOAD_POLL_MS 10
+#define TUNE_QUIET_MS 500 // Idle time before tuning, dictations buffered during the load start within it
+
+// A model loading on its own thread, started by models_load_start and finished by models_load
+typedef struct {
+    char path[1024];
+    utils_thread_t *thread;
+    bool done; // Atomic access required
+    int result;
+} LoadTask;
+
+static LoadTask g_whisper_load;
+static LoadTask g_vad_load;
+static bool g_loading = false; // Atomic access required, from models_load_start until models_load returns
+
+// reload_work and, on Linux, reload_done run on a worker thread
+static utils_mutex_t *g_reload_mutex = NULL;
+static char g_current_path[1024] = {0}; // Whisper model currently loaded, guarded by g_reload_mutex
+static bool g_reloading = false;        // A background reload is running, guarded by g_reload_mutex
+static bool g_reload_pending = false;   // Settings changed again while it was running, guarded by g_reload_mutex
+static bool g_reload_shows_overlay = false; // Guarded by g_reload_mutex
+static bool g_needs_tuning = false;     // Atomic access required, no thread count measured for the model yet
+static char g_reload_error[256];
+
 // Helper function to extract filename from path
 static const char *get_filename_from_path(const char *path) {
     if (!path) return "unknown";
@@ -20,26 +48,118 @@ static const char *get_filename_from_path(const char *path) {
     return filename;
 }
 
-// THE ONE AND ONLY MODEL LOADING FUNCTION
-int models_load(void) {
-    log_info("Starting model loading at %.3f seconds", utils_now());
+static void *load_whisper_work(void *arg) {
+    LoadTask *task = (LoadTask *) arg;
+    log_info("Loading Whisper model: %s", task->path);
+    task->result = transcription_init(task->path);
+    utils_atomic_write_bool(&task->done, true);
+    return NULL;
+}
+
+// Keep the VAD model loaded next to the whisper model instead of reloading it per transcription
+static void *load_vad_work(void *arg) {
+    LoadTask *task = (LoadTask *) arg;
+    task->result = vad_init(task->path);
+    if (task->result != 0) {
+        log_error("Failed to load VAD model, transcribing without voice activity detection");
+    }
+    utils_atomic_write_bool(&task->done, true);
+    return NULL;
+}
+
+static void start_task(LoadTask *task, const char *path, async_work_fn work) {
+    snprintf(task->path, sizeof(task->path), "%s", path);
+    task->result = -1;
+    utils_atomic_write_bool(&task->done, false);
+    task->thread = utils_thread_create(work, task);
+    if (!task->thread) {
+        work(task);
+    }
+}
+
+// Wait for a load, keeping the UI and the hotkey responsive. -1 if it was never started.
+static int finish_task(LoadTask *task) {
+    if (!task->thread) {
+        return task->path[0] ? task->result : -1;
+    }
+    while (!utils_atomic_read_bool(&task->done)) {
+        app_sleep_responsive(LOAD_POLL_MS);
+    }
+    utils_thread_join(task->thread);
+    task->thread = NULL;
+    return task->result;
+}
+
+// Created by the main-thread entry points, before any reload can start
+static void create_reload_mutex(void) {
+    if (!g_reload_mutex) {
+        g_reload_mutex = utils_mutex_create();
+    }
+}
+
+static void set_current_path(const char *path) {
+    utils_mutex_lock(g_reload_mutex);
+    snprintf(g_current_path, sizeof(g_current_path), "%s", path);
+    utils_mutex_unlock(g_reload_mutex);
+}
+
+static void get_current_path(char *path, size_t size) {
+    utils_mutex_lock(g_reload_mutex);
+    snprintf(path, size, "%s", g_current_path);
+    utils_mutex_unlock(g_reload_mutex);
+}
+
+void models_load_start(void) {
+    create_reload_mutex();
+    if (utils_atomic_read_bool(&g_loading)) {
+        return;
+    }
+    utils_atomic_write_bool(&g_loading, true);
 
     // Cleanup existing model first
     transcription_cleanup();
-    
-    overlay_show("Loading model");
+    vad_cleanup();
+    memset(&g_whisper_load, 0, sizeof(g_whisper_load));
+    memset(&g_vad_load, 0, sizeof(g_vad_load));
 
-    // Get the model path from preferences/bundled
+    // Get the model path from preferences/bundled, models_load reports a missing one
     const char *model_path = utils_get_model_path();
-    if (!model_path) {
+    if (model_path) {
+        start_task(&g_whisper_load, model_path, load_whisper_work);
+    }
+    const char *vad_model_path = models_get_vad_path();
+    if (preferences_get_bool("vad_enabled", true) && vad_model_path) {
+        start_task(&g_vad_load, vad_model_path, load_vad_work);
+    }
+}
+
+bool models_is_loading(void) {
+    return utils_atomic_read_bool(&g_loading);
+}
+
+static int load_failed(void) {
+    finish_task(&g_vad_load);
+    utils_atomic_write_bool(&g_loading, false);
+    return -1;
+}
+
+// THE ONE AND ONLY MODEL LOADING FUNCTION
+int models_load(void) {
+    create_reload_mutex();
+    log_info("Starting model loading at %.3f seconds", utils_now());
+    overlay_show("Loading model");
+
+    // Usually started already so the models load while the rest of the app starts
+    models_load_start();
+    int result = finish_task(&g_whisper_load);
+
+    const char *model_path = g_whisper_load.path;
+    if (!model_path[0]) {
         overlay_hide();
         dialog_error("Model Error", "Could not find model file");
-        return -1;
+        return load_failed();
     }
 
-    log_info("Loading Whisper model: %s", model_path);
-    int result = transcription_init(model_path);
-
     if (result != 0) {
         // First failure - try fallback to base model
         const char *failed_model = preferences_get_string("model");
@@ -68,7 +188,8 @@ int models_load(void) {
         overlay_show("Loading base model");
         model_path = utils_get_model_path(); // Get bundled model path
         if (model_path) {
-            result = transcription_init(model_path);
+            start_task(&g_whisper_load, model_path, load_whisper_work);
+            result = finish_task(&g_whisper_load);
         }
 
         if (!model_path || result != 0) {
@@ -84,15 +205,26 @@ int models_load(void) {
             overlay_show_error(error_msg);
             app_sleep_responsive(3000);
             overlay_hide();
-            return -1;
+            return load_failed();
         }
     }
+    finish_task(&g_vad_load);
 
     // Set language from preferences
     const char *language = preferences_get_string("language");
     transcription_set_language(language ? language : "en");
 
     // Model loaded successfully
+    set_current_path(model_path);
+    metrics_set_model(model_path);
+
+    // Use the thread count measured for this model and CPU. Without one, tune in the background
+    // like a reload does, dictation works with the default thread count meanwhile.
+    transcription_warm_up_start();
+    if (!autotune_apply(model_path)) {
+        utils_atomic_write_bool(&g_needs_tuning, true);
+        models_reload();
+    }
     log_info("Model loaded successfully at %.3f seconds", utils_now());
     
     // Keep overlay visible for 1 second for user feedback (but not on startup)
@@ -103,9 +235,130 @@ int models_load(void) {
     is_startup = false;
     
     overlay_hide();
+    utils_atomic_write_bool(&g_loading, false);
     return 0;
 }
 
+static bool model_changed(const char *model_path) {
+    char current_path[sizeof(g_current_path)];
+    get_current_path(current_path, sizeof(current_path));
+    return model_path && strcmp(model_path, current_path) != 0;
+}
+
+// Tuning times inferences and would compete with the warm-up and the first dictations
+static void wait_until_idle(void) {
+    double quiet_since = utils_now();
+    while ((utils_now() - quiet_since) * 1000.0 < TUNE_QUIET_MS) {
+        if (utils_atomic_read_bool(&g_loading) || !transcription_is_idle()) {
+            quiet_since = utils_now();
+        }
+        utils_sleep_ms(LOAD_POLL_MS);
+    }
+}
+
+// Returns NULL or the error to show
+static void *apply_settings(void) {
+    double start = utils_now();
+    const char *model_path = utils_get_model_path();
+    if (!model_path) {
+        snprintf(g_reload_error, sizeof(g_reload_error), "Could not find model file");
+        return g_reload_error;
+    }
+
+    if (model_changed(model_path)) {
+        if (transcription_swap(model_path) != 0) {
+            char current_path[sizeof(g_current_path)];
+            get_current_path(current_path, sizeof(current_path));
+            snprintf(g_reload_error, sizeof(g_reload_error), "Failed to load %s, keeping %s",
+                     get_filename_from_path(model_path), get_filename_from_path(current_path));
+            return g_reload_error;
+        }
+        set_current_path(model_path);
+        metrics_set_model(model_path);
+        if (!autotune_apply(model_path)) {
+            utils_atomic_write_bool(&g_needs_tuning, true);
+        }
+    }
+    if (utils_atomic_read_bool(&g_needs_tuning)) {
+        wait_until_idle();
+        autotune_run(model_path);
+        utils_atomic_write_bool(&g_needs_tuning, false);
+    }
+
+    const char *vad_model_path = models_get_vad_path();
+    if (!preferences_get_bool("vad_enabled", true)) {
+        vad_cleanup();
+    } else if (!vad_is_loaded() && vad_model_path && vad_init(vad_model_path) != 0) {
+        log_error("Failed to load VAD model, transcribing without voice activity detection");
+    }
+
+    const char *language = preferences_get_string("language");
+    transcription_set_language(language ? language : "en");
+
+    log_info("Settings applied in the background (took %.0f ms)", (utils_now() - start) * 1000.0);
+    return NULL;
+}
+
+// Runs on a background thread, returns NULL or the error to show
+static void *reload_work(void *arg) {
+    (void) arg;
+    void *error = apply_settings();
+    trace_thread_exit(); // Tuning traces its runs, every reload gets a new thread
+    return error;
+}
+
+static void reload_done(void *result) {
+    // No other reload starts until g_reloading is cleared below
+    utils_mutex_lock(g_reload_mutex);
+    bool shows_overlay = g_reload_shows_overlay;
+    utils_mutex_unlock(g_reload_mutex);
+    if (result) {
+        log_error("%s", (const char *) result);
+        overlay_show_error((const char *) result);
+    } else if (shows_overlay) {
+        overlay_hide();
+    }
+
+    utils_mutex_lock(g_reload_mutex);
+    g_reloading = false;
+    bool pending = g_reload_pending;
+    g_reload_pending = false;
+    utils_mutex_unlock(g_reload_mutex);
+    if (pending) {
+        models_reload();
+    }
+}
+
+void models_reload(void) {
+    create_reload_mutex();
+    // Dictation keeps working during the reload, only a model switch is worth an overlay
+    bool shows_overlay = model_changed(utils_get_model_path());
+
+    // One reload at a time, the next one picks up everything changed meanwhile
+    utils_mutex_lock(g_reload_mutex);
+    if (g_reloading) {
+        g_reload_pending = true;
+        utils_mutex_unlock(g_reload_mutex);
+        return;
+    }
+    g_reloading = true;
+    g_reload_shows_overlay = shows_overlay;
+    utils_mutex_unlock(g_reload_mutex);
+
+    if (shows_overlay) {
+        overlay_show("Loading model");
+    }
+    utils_execute_async(reload_work, NULL, reload_done);
+}
+
+bool models_get_current_path(char *path, size_t size) {
+    if (!path || size == 0 || !g_reload_mutex) {
+        return false;
+    }
+    get_current_path(path, size);
+    return path[0] != '\0';
+}
+
 // Get VAD model path
 const char *models_get_vad_path(void) {
     return utils_get_vad_model_path();
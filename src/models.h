@@ -2,12 +2,26 @@
 #define MODELS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Model loading - ONE FUNCTION FOR EVERYTHING
 int models_load(void);
+// Start loading the Whisper and VAD models on background threads, each on its own. models_load
+// then waits for them (keeping the UI responsive) and handles failures, calling this first is
+// optional.
+void models_load_start(void);
+// True from models_load_start until models_load returns
+bool models_is_loading(void);
+
+// Apply changed model, language and VAD preferences on a background thread. The loaded model keeps
+// serving dictations until the new one is ready (see transcription_swap), a model that fails to load
+// is reported and the current one stays. Call from the main thread.
+void models_reload(void);
 
 // Model path utilities
-const char *models_get_current_path(void);
+// Copy the path of the loaded Whisper model into path, false if none is loaded yet. A background
+// reload may switch it at any time.
+bool models_get_current_path(char *path, size_t size);
 const char *models_get_vad_path(void);
 bool models_file_exists(const char *path);
 
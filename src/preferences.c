@@ -42,6 +42,20 @@ static void create_default_preferences(void) {
     set_entry("model", "");      // Empty means use embedded model
     set_entry("language", "en"); // Default to English for low latency
     set_entry("vad_enabled", "true"); // VAD enabled by default
+    set_entry("preroll_ms", "0");     // Always-on pre-roll capture disabled by default
+    set_entry("streaming_enabled", "false"); // Transcribe after release by default
+    set_entry("transcription_states", "2");  // Concurrent transcriptions sharing the loaded model
+    set_entry("transcription_threads", "0"); // Threads per transcription, 0 = automatic
+    set_entry("thread_autotune", "true");    // Time thread counts once per model and CPU for the automatic count
+    set_entry("trim_silence", "true");       // Trim silence before and after speech
+    set_entry("trim_padding_ms", "250");     // Audio kept around the trimmed speech
+    set_entry("short_clip_profile", "true"); // Shrink the encoder window for clips under 10 s
+    set_entry("incremental_mel", "true");    // Compute the spectrogram while recording
+    set_entry("transcription_timeout_ms", "60000"); // Abort inference this long after release, 0 = never
+    set_entry("trace_enabled", "false");     // Record latency spans, written as Chrome trace JSON on exit
+    set_entry("metrics_enabled", "true");    // Latency histograms, exported to metrics.prom in the config dir
+    set_entry("metrics_export_path", "");    // Prometheus text file, empty = config dir
+    set_entry("metrics_socket", "");         // Unix socket serving the same text (macOS/Linux), empty = off
 }
 
 static PreferencesEntry *find_entry(const char *key) {
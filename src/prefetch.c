@@ -0,0 +1,98 @@
+#include "prefetch.h"
+#include "logging.h"
+#include "preferences.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PREFETCH_MAX_FILES 2
+
+typedef struct {
+    const char *name;
+    char *path;
+    const void *locked; // Mapping of the file locked in RAM, NULL if not locked
+    size_t locked_size;
+} PrefetchFile;
+
+static PrefetchFile g_files[PREFETCH_MAX_FILES];
+static int g_file_count = 0;
+static bool g_lock = false;
+static bool g_stop = false; // Atomic access required
+static utils_thread_t *g_thread = NULL;
+
+static void prefetch_file(PrefetchFile *file) {
+    double start = utils_now();
+    size_t size = 0;
+    if (!utils_prefetch_file(file->path, &size)) {
+        log_debug("Could not prefetch the %s model: %s", file->name, file->path); // Loading reports it
+        return;
+    }
+    log_info("📀 Prefetched the %s model (%.1f MB in %.0f ms)", file->name, size / 1e6, (utils_now() - start) * 1000.0);
+    if (!g_lock) {
+        return;
+    }
+
+    const void *data = utils_map_file(file->path, &size);
+    if (data && utils_lock_memory(data, size)) {
+        file->locked = data;
+        file->locked_size = size;
+        log_info("📌 Locked the %s model in memory (%.1f MB)", file->name, size / 1e6);
+    } else {
+        utils_unmap_file(data, size);
+        log_error("Could not lock the %s model in memory, check the locked memory limit", file->name);
+    }
+}
+
+static void *prefetch_work(void *arg) {
+    (void) arg;
+    for (int i = 0; i < g_file_count && !utils_atomic_read_bool(&g_stop); i++) {
+        prefetch_file(&g_files[i]);
+    }
+    return NULL;
+}
+
+static void add_file(const char *name, const char *path) {
+    if (path && g_file_count < PREFETCH_MAX_FILES) {
+        g_files[g_file_count].name = name;
+        g_files[g_file_count].path = utils_strdup(path);
+        g_file_count += g_files[g_file_count].path != NULL;
+    }
+}
+
+void prefetch_start(void) {
+    if (g_thread) {
+        return;
+    }
+
+    // Resolve the paths here, the thread only does file I/O
+    add_file("Whisper", utils_get_model_path());
+    if (preferences_get_bool("vad_enabled", true)) {
+        add_file("VAD", utils_get_vad_model_path());
+    }
+    g_lock = preferences_get_bool("model_mlock", false);
+    utils_atomic_write_bool(&g_stop, false);
+
+    g_thread = utils_thread_create(prefetch_work, NULL);
+    if (!g_thread) {
+        log_error("Failed to start model prefetch");
+    }
+}
+
+void prefetch_cleanup(void) {
+    // Quitting doesn't wait for files that haven't started yet
+    utils_atomic_write_bool(&g_stop, true);
+    if (g_thread) {
+        utils_thread_join(g_thread);
+        g_thread = NULL;
+    }
+
+    for (int i = 0; i < g_file_count; i++) {
+        if (g_files[i].locked) {
+            utils_unlock_memory(g_files[i].locked, g_files[i].locked_size);
+            utils_unmap_file(g_files[i].locked, g_files[i].locked_size);
+        }
+        free(g_files[i].path);
+    }
+    memset(g_files, 0, sizeof(g_files));
+    g_file_count = 0;
+}
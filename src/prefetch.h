@@ -0,0 +1,14 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+// Model prefetch - reads the Whisper and VAD model files into the OS file cache on a background
+// thread while the app starts, so loading them after a reboot doesn't wait for a cold disk.
+// With the "model_mlock" preference the files are also locked in RAM until prefetch_cleanup,
+// which keeps later loads (a model swap, another Yakety process) off the disk too.
+
+// Start prefetching utils_get_model_path() and, if VAD is enabled, utils_get_vad_model_path()
+void prefetch_start(void);
+// Wait for prefetching to finish and unlock the locked files
+void prefetch_cleanup(void);
+
+#endif // PREFETCH_H
@@ -0,0 +1,264 @@
+#include "streaming.h"
+#include "audio.h"
+#include "logging.h"
+#include "trace.h"
+#include "transcription.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_SAMPLE_RATE 16000
+#define STREAM_POLL_MS 200
+#define STREAM_READ_CHUNK STREAM_SAMPLE_RATE
+
+// Energy analysis in 20 ms frames
+#define STREAM_FRAME_SAMPLES 320
+#define STREAM_SILENCE_FRAMES 20      // 400 ms below threshold marks a window boundary
+#define STREAM_SILENCE_FLOOR 0.003f   // Absolute RMS floor for silence
+#define STREAM_SILENCE_RATIO 0.1f     // Silence is quieter than 10% of the loudest frame
+
+// Windows shorter than this hurt accuracy, longer than Whisper's 30 s context get split
+#define STREAM_MIN_WINDOW_SAMPLES (STREAM_SAMPLE_RATE * 4)
+#define STREAM_MAX_WINDOW_SAMPLES (STREAM_SAMPLE_RATE * 25)
+#define STREAM_FORCED_CUT_SEARCH_SAMPLES (STREAM_SAMPLE_RATE * 5)
+#define STREAM_MIN_TAIL_SAMPLES (STREAM_SAMPLE_RATE / 4)
+
+struct StreamingSession {
+    utils_thread_t *thread;
+    bool running; // Atomic access required
+    TranscriptionCancel cancel; // Aborts an in-flight window on streaming_cancel()
+
+    // Audio pulled from the recorder but not transcribed yet
+    int consumed; // Samples covered by finished windows
+    int read_offset;
+    float *pending;
+    int pending_count;
+    int pending_capacity;
+
+    // Concatenated text of finished windows
+    char *text;
+    size_t text_len;
+    int windows;
+};
+
+// Pull everything recorded since the last call into the pending buffer
+static void pull_samples(StreamingSession *session) {
+    for (;;) {
+        if (session->pending_count + STREAM_READ_CHUNK > session->pending_capacity) {
+            int new_capacity = session->pending_capacity * 2;
+            if (new_capacity < session->pending_count + STREAM_READ_CHUNK) {
+                new_capacity = session->pending_count + STREAM_READ_CHUNK;
+            }
+            float *new_pending = (float *) realloc(session->pending, (size_t) new_capacity * sizeof(float));
+            if (!new_pending) {
+                log_error("Streaming: failed to grow pending buffer");
+                return;
+            }
+            session->pending = new_pending;
+            session->pending_capacity = new_capacity;
+        }
+
+        int count = audio_recorder_read_samples(session->read_offset, session->pending + session->pending_count,
+                                                STREAM_READ_CHUNK);
+        session->read_offset += count;
+        session->pending_count += count;
+        if (count < STREAM_READ_CHUNK) {
+            return;
+        }
+    }
+}
+
+// Find where to end the next window: the middle of the latest long enough pause,
+// or the quietest frame once the window grows too long. Returns 0 if the window isn't finished yet.
+static int find_window_cut(const float *samples, int count) {
+    if (count < STREAM_MIN_WINDOW_SAMPLES) {
+        return 0;
+    }
+
+    int n_frames = count / STREAM_FRAME_SAMPLES;
+    float *rms = (float *) malloc((size_t) n_frames * sizeof(float));
+    if (!rms) {
+        return 0;
+    }
+
+    float peak = 0.0f;
+    for (int i = 0; i < n_frames; i++) {
+        const float *frame = samples + i * STREAM_FRAME_SAMPLES;
+        float sum = 0.0f;
+        for (int j = 0; j < STREAM_FRAME_SAMPLES; j++) {
+            sum += frame[j] * frame[j];
+        }
+        rms[i] = sqrtf(sum / STREAM_FRAME_SAMPLES);
+        if (rms[i] > peak) {
+            peak = rms[i];
+        }
+    }
+
+    float threshold = peak * STREAM_SILENCE_RATIO;
+    if (threshold < STREAM_SILENCE_FLOOR) {
+        threshold = STREAM_SILENCE_FLOOR;
+    }
+
+    // Scan backwards for the latest silent run that is long enough
+    int min_frame = STREAM_MIN_WINDOW_SAMPLES / STREAM_FRAME_SAMPLES;
+    int cut = 0;
+    int run_end = -1;
+    for (int i = n_frames - 1; i >= -1 && cut == 0; i--) {
+        bool silent = i >= 0 && rms[i] < threshold;
+        if (silent) {
+            if (run_end < 0) {
+                run_end = i;
+            }
+            continue;
+        }
+        if (run_end >= 0) {
+            int run_start = i + 1;
+            int mid = (run_start + run_end) / 2;
+            if (run_end - run_start + 1 >= STREAM_SILENCE_FRAMES && mid >= min_frame) {
+                cut = mid * STREAM_FRAME_SAMPLES;
+            }
+            run_end = -1;
+        }
+    }
+
+    // No pause found but the window is getting too long: cut at the quietest recent frame
+    if (cut == 0 && count >= STREAM_MAX_WINDOW_SAMPLES) {
+        int last = STREAM_MAX_WINDOW_SAMPLES / STREAM_FRAME_SAMPLES - 1;
+        int first = (STREAM_MAX_WINDOW_SAMPLES - STREAM_FORCED_CUT_SEARCH_SAMPLES) / STREAM_FRAME_SAMPLES;
+        int quietest = last;
+        for (int i = first; i <= last; i++) {
+            if (rms[i] < rms[quietest]) {
+                quietest = i;
+            }
+        }
+        cut = quietest * STREAM_FRAME_SAMPLES;
+    }
+
+    free(rms);
+    return cut;
+}
+
+static void append_text(StreamingSession *session, const char *text) {
+    size_t len = strlen(text);
+    if (len == 0) {
+        return;
+    }
+
+    char *new_text = (char *) realloc(session->text, session->text_len + len + 1);
+    if (!new_text) {
+        log_error("Streaming: failed to grow text buffer");
+        return;
+    }
+    memcpy(new_text + session->text_len, text, len + 1);
+    session->text = new_text;
+    session->text_len += len;
+}
+
+static void transcribe_window(StreamingSession *session, const float *samples, int count, TranscriptionCancel *cancel) {
+    session->windows++;
+    log_info("🧩 Streaming window %d: %.2f seconds", session->windows, (float) count / STREAM_SAMPLE_RATE);
+
+    double start = utils_now();
+    char *text = transcription_run(samples, count, STREAM_SAMPLE_RATE, NULL, cancel, NULL).text;
+    log_info("⏱️  Streaming window %d took: %.0f ms", session->windows, (utils_now() - start) * 1000.0);
+
+    if (text) {
+        append_text(session, text);
+        free(text);
+    }
+    session->consumed += count;
+}
+
+// Transcribe the first count pending samples and drop them from the pending buffer
+static void transcribe_pending(StreamingSession *session, int count) {
+    transcribe_window(session, session->pending, count, &session->cancel);
+
+    session->pending_count -= count;
+    memmove(session->pending, session->pending + count, (size_t) session->pending_count * sizeof(float));
+}
+
+static void *streaming_worker(void *arg) {
+    StreamingSession *session = (StreamingSession *) arg;
+
+    while (utils_atomic_read_bool(&session->running)) {
+        utils_sleep_ms(STREAM_POLL_MS);
+
+        // Anything pulled after streaming_stop() may belong to the next recording; the
+        // running check after the pull makes sure it is never transcribed
+        pull_samples(session);
+        int cut = find_window_cut(session->pending, session->pending_count);
+        if (cut > 0 && utils_atomic_read_bool(&session->running)) {
+            transcribe_pending(session, cut);
+        }
+    }
+    trace_thread_exit();
+    return NULL;
+}
+
+static void free_session(StreamingSession *session) {
+    free(session->pending);
+    free(session->text);
+    free(session);
+}
+
+StreamingSession *streaming_start(void) {
+    StreamingSession *session = (StreamingSession *) calloc(1, sizeof(StreamingSession));
+    if (!session) {
+        return NULL;
+    }
+
+    utils_atomic_write_bool(&session->running, true);
+    transcription_cancel_init(&session->cancel, 0);
+    session->thread = utils_thread_create(streaming_worker, session);
+    if (!session->thread) {
+        log_error("Failed to start streaming transcription worker");
+        free_session(session);
+        return NULL;
+    }
+
+    return session;
+}
+
+void streaming_stop(StreamingSession *session) {
+    if (session) {
+        utils_atomic_write_bool(&session->running, false);
+    }
+}
+
+// Stop the worker and wait for it; an in-flight window finishes first
+static void join_worker(StreamingSession *session) {
+    streaming_stop(session);
+    if (session->thread) {
+        utils_thread_join(session->thread);
+        session->thread = NULL;
+    }
+}
+
+char *streaming_finish(StreamingSession *session, const float *samples, int n_samples, TranscriptionCancel *cancel) {
+    if (!session) {
+        return NULL;
+    }
+    join_worker(session);
+
+    // The tail comes from the final recording, the worker's pending buffer may be stale
+    int tail = n_samples - session->consumed;
+    log_info("🧩 Streaming tail: %.2f seconds after %d window(s)", (float) (tail > 0 ? tail : 0) / STREAM_SAMPLE_RATE,
+             session->windows);
+    if (samples && tail >= STREAM_MIN_TAIL_SAMPLES) {
+        transcribe_window(session, samples + session->consumed, tail, cancel);
+    }
+
+    char *text = session->text ? session->text : utils_strdup("");
+    session->text = NULL;
+    free_session(session);
+    return text;
+}
+
+void streaming_cancel(StreamingSession *session) {
+    if (session) {
+        transcription_cancel(&session->cancel);
+        join_worker(session);
+        free_session(session);
+    }
+}
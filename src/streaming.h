@@ -0,0 +1,29 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include "transcription.h"
+#include <stdbool.h>
+
+// Streaming transcription - a session is tied to one memory recording.
+// While recording, a worker transcribes finished windows (cut at silence) in the background
+// so that only the tail is left to decode when the hotkey is released.
+typedef struct StreamingSession StreamingSession;
+
+// Start a session. Call right after audio_recorder_start() succeeded.
+// Returns NULL if the worker could not be started (caller falls back to batch transcription).
+StreamingSession *streaming_start(void);
+
+// Stop pulling audio from the recorder. Non-blocking, call on release before audio_recorder_stop()
+// so the recorder can be restarted right away.
+void streaming_stop(StreamingSession *session);
+
+// Finish the session with the complete recording (as returned by audio_recorder_get_samples()).
+// Waits for an in-flight window, transcribes the remaining tail and returns all text (malloc'd,
+// caller frees), same format as transcription_process(). Frees the session.
+// cancel (may be NULL) aborts the tail, the text of finished windows is still returned.
+char *streaming_finish(StreamingSession *session, const float *samples, int n_samples, TranscriptionCancel *cancel);
+
+// Abort the session, discard its text and free it. An in-flight window is cancelled.
+void streaming_cancel(StreamingSession *session);
+
+#endif // STREAMING_H
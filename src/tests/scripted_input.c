@@ -0,0 +1,135 @@
+#include "scripted_input.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../app.h"
+#include "../clipboard.h"
+#include "../keylogger.h"
+#include "../utils.h"
+
+static ScriptFn g_script = NULL;
+
+// Keylogger: no OS hook, the script thread fires the callbacks
+static KeyCallback g_on_press = NULL;
+static KeyCallback g_on_release = NULL;
+static void *g_userdata = NULL;
+static utils_thread_t *g_script_thread = NULL;
+static bool g_stop = false; // Atomic access required
+
+// Clipboard: remembers the last paste
+static utils_mutex_t *g_paste_mutex = NULL;
+static char *g_copied_text = NULL;
+static char *g_pasted_text = NULL;
+static double g_pasted_at = 0.0;
+static int g_pastes = 0;
+
+bool scripted_input_init(ScriptFn script) {
+    g_script = script;
+    if (!g_paste_mutex) {
+        g_paste_mutex = utils_mutex_create();
+    }
+    return g_paste_mutex != NULL;
+}
+
+void scripted_input_cleanup(void) {
+    free(g_copied_text);
+    free(g_pasted_text);
+    g_copied_text = NULL;
+    g_pasted_text = NULL;
+    utils_mutex_destroy(g_paste_mutex);
+    g_paste_mutex = NULL;
+}
+
+void scripted_input_press(void) {
+    g_on_press(g_userdata);
+}
+
+void scripted_input_release(void) {
+    g_on_release(g_userdata);
+}
+
+bool scripted_input_sleep_ms(int milliseconds) {
+    for (int slept = 0; slept < milliseconds; slept += 5) {
+        if (utils_atomic_read_bool(&g_stop) || !app_is_running()) {
+            return false;
+        }
+        utils_sleep_ms(5);
+    }
+    return !utils_atomic_read_bool(&g_stop) && app_is_running();
+}
+
+int scripted_input_paste_count(void) {
+    utils_mutex_lock(g_paste_mutex);
+    int count = g_pastes;
+    utils_mutex_unlock(g_paste_mutex);
+    return count;
+}
+
+double scripted_input_last_paste(char *text, size_t size) {
+    utils_mutex_lock(g_paste_mutex);
+    double pasted_at = g_pasted_at;
+    if (text && size > 0) {
+        strncpy(text, g_pasted_text ? g_pasted_text : "", size - 1);
+        text[size - 1] = '\0';
+    }
+    utils_mutex_unlock(g_paste_mutex);
+    return pasted_at;
+}
+
+void clipboard_copy(const char *text) {
+    utils_mutex_lock(g_paste_mutex);
+    free(g_copied_text);
+    g_copied_text = utils_strdup(text);
+    utils_mutex_unlock(g_paste_mutex);
+}
+
+void clipboard_paste(void) {
+    double now = utils_now();
+    utils_mutex_lock(g_paste_mutex);
+    free(g_pasted_text);
+    g_pasted_text = g_copied_text ? utils_strdup(g_copied_text) : NULL;
+    g_pasted_at = now;
+    g_pastes++;
+    utils_mutex_unlock(g_paste_mutex);
+}
+
+static void *script_thread_proc(void *arg) {
+    (void) arg;
+    if (g_script) {
+        g_script();
+    }
+    app_quit();
+    return NULL;
+}
+
+int keylogger_init(KeyCallback on_press, KeyCallback on_release, KeyCallback on_key_cancel, void *userdata) {
+    (void) on_key_cancel;
+    g_on_press = on_press;
+    g_on_release = on_release;
+    g_userdata = userdata;
+    utils_atomic_write_bool(&g_stop, false);
+    g_script_thread = utils_thread_create(script_thread_proc, NULL);
+    return g_script_thread ? 0 : -1;
+}
+
+void keylogger_cleanup(void) {
+    if (g_script_thread) {
+        utils_atomic_write_bool(&g_stop, true);
+        utils_thread_join(g_script_thread);
+        g_script_thread = NULL;
+    }
+}
+
+void keylogger_pause(void) {
+}
+
+void keylogger_resume(void) {
+}
+
+void keylogger_set_combination(const KeyCombination *combo) {
+    (void) combo;
+}
+
+KeyCombination keylogger_get_fn_combination(void) {
+    KeyCombination combo = {0};
+    return combo;
+}
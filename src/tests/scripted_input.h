@@ -0,0 +1,30 @@
+#ifndef SCRIPTED_INPUT_H
+#define SCRIPTED_INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Scripted keylogger and recording clipboard for running app_main headless. Linked in place of the
+// platform's keylogger and clipboard: keylogger_init starts the script on its own thread, pastes
+// are recorded instead of sent to the focused window.
+
+typedef void (*ScriptFn)(void);
+
+// Call before app_main. app_quit is called when the script returns.
+bool scripted_input_init(ScriptFn script);
+void scripted_input_cleanup(void);
+
+// The hotkey, call from the script
+void scripted_input_press(void);
+void scripted_input_release(void);
+
+// Sleep in small steps. Returns false once the app is quitting, the script should return then.
+bool scripted_input_sleep_ms(int milliseconds);
+
+// Pastes so far
+int scripted_input_paste_count(void);
+
+// Time (utils_now) of the latest paste, its text is copied to text (truncated to size). 0 if none yet.
+double scripted_input_last_paste(char *text, size_t size);
+
+#endif // SCRIPTED_INPUT_H
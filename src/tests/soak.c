@@ -0,0 +1,367 @@
+// yakety-soak: runs the real app for thousands of dictations to catch what only shows up after weeks
+// of uptime. A virtual microphone plays a WAV file and a scripted hotkey (scripted_input.h) holds it
+// for a random length each cycle, so recordings are cut mid-speech or padded with silence. Every
+// --report-every cycles it samples RSS, open file descriptors, malloc heap use and fragmentation and
+// the release-to-done latency, and at the end compares the last window with the first one.
+//
+// Usage: yakety-soak <clip.wav> [options], see print_usage. Exits with 1 if dictations hung and
+// with 2 if memory, descriptors or latency grew past the limits.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "../app.h"
+#include "../audio.h"
+#include "../transcription.h"
+#include "../utils.h"
+#include "scripted_input.h"
+
+#define DEFAULT_CYCLES 2000
+#define DEFAULT_SPEED 4.0
+#define DEFAULT_MIN_CLIP 0.5
+#define DEFAULT_MAX_CLIP 8.0
+#define DEFAULT_REPORT_EVERY 50
+#define DEFAULT_MAX_RSS_GROWTH_MB 64.0
+#define DEFAULT_MAX_FD_GROWTH 0
+#define DEFAULT_MAX_LATENCY_DRIFT 1.5 // Last window median over first window median
+#define MIN_HOLD_MS 150               // The app ignores key presses shorter than 100 ms
+#define EMPTY_GRACE_MS 250            // Paste wait after a transcription finished, it may have had no text
+#define DONE_TIMEOUT_MS 60000
+#define PAUSE_BETWEEN_CYCLES_MS 50
+#define EXIT_REGRESSION 2
+
+typedef struct {
+    const char *output_path;
+    int cycles;
+    int report_every;
+    double speed;
+    double min_clip;
+    double max_clip;
+    double max_rss_growth_mb;
+    int max_fd_growth;
+    double max_latency_drift;
+    unsigned int seed;
+} SoakOptions;
+
+// One --report-every window
+typedef struct {
+    int cycle;
+    double elapsed_s;
+    size_t rss;
+    size_t peak_rss;
+    int open_fds;
+    size_t heap_used; // 0 without glibc
+    size_t heap_free;
+    double p50_ms;
+    double p95_ms;
+    int hung;
+} SoakSample;
+
+static SoakOptions g_options;
+static FILE *g_output = NULL;
+static SoakSample g_first;
+static SoakSample g_last;
+static int g_samples = 0;
+static int g_total_hung = 0;
+static bool g_finished = false;
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const double *sorted, int count, double p) {
+    if (count == 0) {
+        return 0.0;
+    }
+    int rank = (int) (p / 100.0 * count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+// xorshift32, the same clip lengths for the same --seed on every platform
+static double next_random(unsigned int *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (double) *state / 4294967296.0;
+}
+
+// Transcriptions that reached an outcome, pasted or not. Failed runs aren't counted anywhere and
+// end up as hung cycles.
+static int transcriptions_done(void) {
+    TranscriptionTimingStats timing;
+    TranscriptionSkipStats skips;
+    transcription_get_timing_stats(&timing);
+    transcription_get_skip_stats(&skips);
+    return timing.runs + skips.skipped_too_short + skips.skipped_silent + skips.skipped_no_speech + skips.cancelled;
+}
+
+static void heap_stats(size_t *used, size_t *free_bytes) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    *used = info.uordblks + info.hblkhd;
+    *free_bytes = info.fordblks;
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    *used = (size_t) (unsigned int) info.uordblks + (size_t) (unsigned int) info.hblkhd;
+    *free_bytes = (size_t) (unsigned int) info.fordblks;
+#else
+    *used = 0;
+    *free_bytes = 0;
+#endif
+}
+
+// Free heap that malloc holds on to, in percent of what it holds
+static double fragmentation(const SoakSample *sample) {
+    size_t held = sample->heap_used + sample->heap_free;
+    return held > 0 ? 100.0 * (double) sample->heap_free / (double) held : 0.0;
+}
+
+static void take_sample(SoakSample *sample, int cycle, double start, double *latencies_ms, int count, int hung) {
+    qsort(latencies_ms, (size_t) count, sizeof(double), compare_doubles);
+    sample->cycle = cycle;
+    sample->elapsed_s = utils_now() - start;
+    sample->rss = utils_get_rss();
+    sample->peak_rss = utils_get_peak_rss();
+    sample->open_fds = utils_get_open_handle_count();
+    heap_stats(&sample->heap_used, &sample->heap_free);
+    sample->p50_ms = percentile(latencies_ms, count, 50);
+    sample->p95_ms = percentile(latencies_ms, count, 95);
+    sample->hung = hung;
+}
+
+static void report_sample(const SoakSample *sample) {
+    const double mb = 1024.0 * 1024.0;
+    printf("cycle %5d  %6.0f s  rss %7.1f MB (peak %7.1f)  fds %3d  heap %7.1f MB used %6.1f MB free (%4.1f%%)  "
+           "latency p50 %5.0f ms p95 %5.0f ms  hung %d\n",
+           sample->cycle, sample->elapsed_s, sample->rss / mb, sample->peak_rss / mb, sample->open_fds,
+           sample->heap_used / mb, sample->heap_free / mb, fragmentation(sample), sample->p50_ms, sample->p95_ms,
+           sample->hung);
+    fflush(stdout);
+    if (g_output) {
+        fprintf(g_output, "%d,%.1f,%zu,%zu,%d,%zu,%zu,%.2f,%.1f,%.1f,%d\n", sample->cycle, sample->elapsed_s,
+                sample->rss, sample->peak_rss, sample->open_fds, sample->heap_used, sample->heap_free,
+                fragmentation(sample), sample->p50_ms, sample->p95_ms, sample->hung);
+        fflush(g_output);
+    }
+}
+
+// One dictation of clip_seconds. Returns the release-to-done latency in ms, negative if it hung.
+static double run_cycle(double clip_seconds) {
+    audio_recorder_virtual_mic_rewind();
+    scripted_input_press();
+    int hold_ms = (int) (clip_seconds * 1000.0 / g_options.speed);
+    if (!scripted_input_sleep_ms(hold_ms < MIN_HOLD_MS ? MIN_HOLD_MS : hold_ms)) {
+        return -1.0;
+    }
+
+    int pastes = scripted_input_paste_count();
+    int done = transcriptions_done();
+    double release = utils_now();
+    scripted_input_release();
+
+    double done_at = 0.0;
+    for (;;) {
+        if (scripted_input_paste_count() != pastes) {
+            return (scripted_input_last_paste(NULL, 0) - release) * 1000.0;
+        }
+        double now = utils_now();
+        if (done_at == 0.0 && transcriptions_done() != done) {
+            done_at = now;
+        }
+        if (done_at > 0.0 && (now - done_at) * 1000.0 > EMPTY_GRACE_MS) {
+            return (done_at - release) * 1000.0; // Nothing to paste
+        }
+        if ((now - release) * 1000.0 > DONE_TIMEOUT_MS || !scripted_input_sleep_ms(2)) {
+            return -1.0;
+        }
+    }
+}
+
+static void run_script(void) {
+    double *latencies_ms = (double *) malloc((size_t) g_options.report_every * sizeof(double));
+    if (!latencies_ms) {
+        return;
+    }
+
+    unsigned int random = g_options.seed ? g_options.seed : 1;
+    double start = utils_now();
+    int count = 0;
+    int hung = 0;
+    for (int cycle = 1; cycle <= g_options.cycles; cycle++) {
+        double clip_seconds =
+            g_options.min_clip + (g_options.max_clip - g_options.min_clip) * next_random(&random);
+        double latency_ms = run_cycle(clip_seconds);
+        if (!app_is_running()) {
+            break;
+        }
+        if (latency_ms < 0) {
+            printf("cycle %d: HUNG, no transcription within %d ms of release (%.1f s clip)\n", cycle,
+                   DONE_TIMEOUT_MS, clip_seconds);
+            hung++;
+            g_total_hung++;
+        } else {
+            latencies_ms[count++] = latency_ms;
+        }
+
+        if (cycle % g_options.report_every == 0 || cycle == g_options.cycles) {
+            SoakSample sample;
+            take_sample(&sample, cycle, start, latencies_ms, count, hung);
+            report_sample(&sample);
+            // The first window warms up caches and the whisper state pool, it is the baseline
+            if (g_samples++ == 0) {
+                g_first = sample;
+            }
+            g_last = sample;
+            count = 0;
+            hung = 0;
+        }
+        if (!scripted_input_sleep_ms(PAUSE_BETWEEN_CYCLES_MS)) {
+            break;
+        }
+    }
+    g_finished = true;
+    free(latencies_ms);
+}
+
+// Compare the last window with the first. Returns false if anything grew past its limit.
+static bool check_drift(void) {
+    const double mb = 1024.0 * 1024.0;
+    double rss_growth_mb = ((double) g_last.rss - (double) g_first.rss) / mb;
+    int fd_growth = g_last.open_fds - g_first.open_fds;
+    double latency_drift = g_first.p50_ms > 0 ? g_last.p50_ms / g_first.p50_ms : 1.0;
+
+    printf("\n=== Soak: %d cycles in %.0f s, %d hung ===\n", g_last.cycle, g_last.elapsed_s, g_total_hung);
+    printf("RSS growth:          %+.1f MB (limit %.0f MB)\n", rss_growth_mb, g_options.max_rss_growth_mb);
+    printf("Open fd growth:      %+d (limit %d)\n", fd_growth, g_options.max_fd_growth);
+    printf("Heap fragmentation:  %.1f%% -> %.1f%%\n", fragmentation(&g_first), fragmentation(&g_last));
+    printf("Latency p50 drift:   %.0f ms -> %.0f ms (x%.2f, limit x%.2f)\n", g_first.p50_ms, g_last.p50_ms,
+           latency_drift, g_options.max_latency_drift);
+
+    bool ok = true;
+    if (rss_growth_mb > g_options.max_rss_growth_mb) {
+        printf("FAIL: RSS grew by %.1f MB\n", rss_growth_mb);
+        ok = false;
+    }
+    if (fd_growth > g_options.max_fd_growth) {
+        printf("FAIL: %d file descriptors leaked\n", fd_growth);
+        ok = false;
+    }
+    if (latency_drift > g_options.max_latency_drift) {
+        printf("FAIL: median latency drifted x%.2f\n", latency_drift);
+        ok = false;
+    }
+    return ok;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s <clip.wav> [options]\n", program);
+    printf("Options:\n");
+    printf("  --model <path>               Whisper model (default: configured model)\n");
+    printf("  --cycles <n>                 Dictations to run (default %d)\n", DEFAULT_CYCLES);
+    printf("  --speed <x>                  Microphone playback speed, 1 = real time (default %.0f)\n", DEFAULT_SPEED);
+    printf("  --min-clip <seconds>         Shortest key hold in clip time (default %.1f)\n", DEFAULT_MIN_CLIP);
+    printf("  --max-clip <seconds>         Longest key hold in clip time (default %.1f)\n", DEFAULT_MAX_CLIP);
+    printf("  --seed <n>                   Seed for the clip lengths (default 1)\n");
+    printf("  --report-every <n>           Cycles per sample (default %d)\n", DEFAULT_REPORT_EVERY);
+    printf("  --output <file.csv>          Write the samples as CSV\n");
+    printf("  --max-rss-growth-mb <mb>     Allowed RSS growth, first to last sample (default %.0f)\n",
+           DEFAULT_MAX_RSS_GROWTH_MB);
+    printf("  --max-fd-growth <n>          Allowed open descriptor growth (default %d)\n", DEFAULT_MAX_FD_GROWTH);
+    printf("  --max-latency-drift <x>      Allowed median latency ratio (default %.1f)\n", DEFAULT_MAX_LATENCY_DRIFT);
+}
+
+int main(int argc, char *argv[]) {
+    const char *wav_path = NULL;
+    char *model_path = NULL;
+    g_options.cycles = DEFAULT_CYCLES;
+    g_options.report_every = DEFAULT_REPORT_EVERY;
+    g_options.speed = DEFAULT_SPEED;
+    g_options.min_clip = DEFAULT_MIN_CLIP;
+    g_options.max_clip = DEFAULT_MAX_CLIP;
+    g_options.max_rss_growth_mb = DEFAULT_MAX_RSS_GROWTH_MB;
+    g_options.max_fd_growth = DEFAULT_MAX_FD_GROWTH;
+    g_options.max_latency_drift = DEFAULT_MAX_LATENCY_DRIFT;
+    g_options.seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--model") == 0 && has_value) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--cycles") == 0 && has_value) {
+            g_options.cycles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            g_options.speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--min-clip") == 0 && has_value) {
+            g_options.min_clip = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-clip") == 0 && has_value) {
+            g_options.max_clip = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            g_options.seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--report-every") == 0 && has_value) {
+            g_options.report_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+            g_options.output_path = argv[++i];
+        } else if (strcmp(argv[i], "--max-rss-growth-mb") == 0 && has_value) {
+            g_options.max_rss_growth_mb = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-fd-growth") == 0 && has_value) {
+            g_options.max_fd_growth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-latency-drift") == 0 && has_value) {
+            g_options.max_latency_drift = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !wav_path) {
+            wav_path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!wav_path || g_options.cycles < 1 || g_options.report_every < 1 || g_options.speed <= 0 ||
+        g_options.min_clip <= 0 || g_options.max_clip < g_options.min_clip) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (g_options.output_path) {
+        g_output = fopen(g_options.output_path, "w");
+        if (!g_output) {
+            printf("Failed to open %s\n", g_options.output_path);
+            return 1;
+        }
+        fprintf(g_output, "cycle,elapsed_s,rss_bytes,peak_rss_bytes,open_fds,heap_used_bytes,heap_free_bytes,"
+                          "fragmentation_pct,latency_p50_ms,latency_p95_ms,hung\n");
+    }
+
+    if (!scripted_input_init(run_script) || !audio_recorder_use_virtual_mic(wav_path, g_options.speed)) {
+        printf("Failed to set up the virtual microphone for %s\n", wav_path);
+        return 1;
+    }
+
+    // The app parses its own command line, hand it only the model
+    char *app_argv[] = {argv[0], "--model", model_path, NULL};
+    int result = app_main(model_path ? 3 : 1, app_argv, true);
+    scripted_input_cleanup();
+    if (g_output) {
+        fclose(g_output);
+    }
+
+    if (result != 0) {
+        return result;
+    }
+    if (g_samples == 0) {
+        printf("Soak stopped before the first sample\n");
+        return 1;
+    }
+    bool ok = check_drift();
+    if (!g_finished || g_total_hung > 0) {
+        return 1;
+    }
+    return ok ? 0 : EXIT_REGRESSION;
+}
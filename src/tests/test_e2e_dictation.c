@@ -0,0 +1,152 @@
+// Headless end-to-end dictation test: runs the real app with a virtual microphone playing a WAV file
+// and a scripted hotkey (scripted_input.h), then checks the release-to-paste latency of every
+// dictation against a budget. Needs no sound card, keyboard or display.
+//
+// Usage: test-e2e-dictation <clip.wav> [--model <path>] [--cycles <n>] [--speed <x>] [--budget-ms <ms>]
+// Exits with 1 if a dictation produced no paste or went over the budget.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../app.h"
+#include "../audio.h"
+#include "../utils.h"
+#include "scripted_input.h"
+
+#define DEFAULT_CYCLES 3
+#define DEFAULT_SPEED 1.0
+#define DEFAULT_BUDGET_MS 2000.0
+#define MAX_CYCLES 100
+#define HOLD_AFTER_CLIP_MS 100 // Keep the key down a little after the speech, like a person would
+#define PAUSE_BETWEEN_CYCLES_MS 500
+#define PASTE_TIMEOUT_MS 60000
+#define CLIP_TIMEOUT_MS 120000.0 // At real-time speed
+
+static int g_cycles = DEFAULT_CYCLES;
+static double g_budget_ms = DEFAULT_BUDGET_MS;
+static double g_clip_timeout_ms = CLIP_TIMEOUT_MS;
+
+// Results, written by the script thread and read after app_main returns
+static double g_latencies_ms[MAX_CYCLES];
+static int g_completed = 0;
+static int g_failures = 0;
+
+// One dictation: press, let the clip play into the microphone, release, wait for the paste
+static bool run_cycle(int cycle) {
+    audio_recorder_virtual_mic_rewind();
+    scripted_input_press();
+
+    double press = utils_now();
+    while (!audio_recorder_virtual_mic_finished()) {
+        if ((utils_now() - press) * 1000.0 > g_clip_timeout_ms || !scripted_input_sleep_ms(10)) {
+            printf("cycle %d: FAILED, the microphone never finished the clip\n", cycle + 1);
+            return false;
+        }
+    }
+    if (!scripted_input_sleep_ms(HOLD_AFTER_CLIP_MS)) {
+        return false;
+    }
+
+    int pastes = scripted_input_paste_count();
+    double release = utils_now();
+    scripted_input_release();
+
+    while (scripted_input_paste_count() == pastes) {
+        if ((utils_now() - release) * 1000.0 > PASTE_TIMEOUT_MS || !scripted_input_sleep_ms(5)) {
+            printf("cycle %d: FAILED, nothing was pasted\n", cycle + 1);
+            return false;
+        }
+    }
+
+    char text[1024];
+    double latency_ms = (scripted_input_last_paste(text, sizeof(text)) - release) * 1000.0;
+    printf("cycle %d: %.0f ms release to paste%s \"%s\"\n", cycle + 1, latency_ms,
+           latency_ms > g_budget_ms ? " (OVER BUDGET)" : "", text);
+
+    g_latencies_ms[cycle] = latency_ms;
+    return latency_ms <= g_budget_ms;
+}
+
+static void run_script(void) {
+    for (int cycle = 0; cycle < g_cycles; cycle++) {
+        if (!run_cycle(cycle)) {
+            g_failures++;
+        }
+        g_completed++;
+        if (!scripted_input_sleep_ms(PAUSE_BETWEEN_CYCLES_MS)) {
+            break;
+        }
+    }
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s <clip.wav> [options]\n", program);
+    printf("Options:\n");
+    printf("  --model <path>      Whisper model (default: configured model)\n");
+    printf("  --cycles <n>        Dictations to run (default %d)\n", DEFAULT_CYCLES);
+    printf("  --speed <x>         Microphone playback speed, 1 = real time (default %.0f)\n", DEFAULT_SPEED);
+    printf("  --budget-ms <ms>    Allowed release-to-paste latency (default %.0f)\n", DEFAULT_BUDGET_MS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *wav_path = NULL;
+    char *model_path = NULL;
+    double speed = DEFAULT_SPEED;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--model") == 0 && has_value) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--cycles") == 0 && has_value) {
+            g_cycles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--speed") == 0 && has_value) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--budget-ms") == 0 && has_value) {
+            g_budget_ms = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !wav_path) {
+            wav_path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!wav_path || g_cycles < 1 || g_cycles > MAX_CYCLES || speed <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!scripted_input_init(run_script) || !audio_recorder_use_virtual_mic(wav_path, speed)) {
+        printf("Failed to set up the virtual microphone for %s\n", wav_path);
+        return 1;
+    }
+    g_clip_timeout_ms = CLIP_TIMEOUT_MS / speed;
+
+    // The app parses its own command line, hand it only the model
+    char *app_argv[] = {argv[0], "--model", model_path, NULL};
+    int result = app_main(model_path ? 3 : 1, app_argv, true);
+    scripted_input_cleanup();
+
+    double sorted[MAX_CYCLES];
+    int n_pasted = 0;
+    for (int i = 0; i < g_completed; i++) {
+        if (g_latencies_ms[i] > 0) {
+            sorted[n_pasted++] = g_latencies_ms[i];
+        }
+    }
+    printf("\n=== %d of %d dictations within %.0f ms ===\n", g_completed - g_failures, g_cycles, g_budget_ms);
+    if (n_pasted > 0) {
+        qsort(sorted, (size_t) n_pasted, sizeof(double), compare_doubles);
+        printf("Release to paste: median %.0f ms, max %.0f ms\n", sorted[n_pasted / 2], sorted[n_pasted - 1]);
+    }
+
+    if (result != 0) {
+        return result;
+    }
+    return g_completed == g_cycles && g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#include "trace.h"
+#include "logging.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Enough for hundreds of dictations per thread, later events are dropped and counted
+#define TRACE_EVENTS_PER_THREAD 8192
+// Buffers of exited threads are reused, this caps the total at about 12 MB for threads that never exit
+#define TRACE_MAX_BUFFERS 64
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL __thread
+#endif
+
+typedef struct {
+    const char *name;
+    double start;
+    double end; // Negative for instants
+} TraceEvent;
+
+// Written by its thread only. Events are filled in before count is published, so a reader
+// that loads count sees complete events. When the thread exits the buffer goes on the free list
+// with its events, and the next thread that needs one appends to it under the same tid.
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;
+    struct TraceBuffer *next_free;
+    int tid;
+    int count;   // Atomic access required
+    int dropped; // Atomic access required
+    TraceEvent events[TRACE_EVENTS_PER_THREAD];
+} TraceBuffer;
+
+static bool g_enabled = false; // Atomic access required
+static int g_generation = 0;   // Atomic access required, invalidates thread buffers across init/cleanup
+static utils_mutex_t *g_trace_mutex = NULL;
+static TraceBuffer *g_buffers = NULL;      // Guarded by g_trace_mutex
+static TraceBuffer *g_free_buffers = NULL; // Guarded by g_trace_mutex, buffers of exited threads
+static int g_thread_count = 0;             // Buffers allocated, guarded by g_trace_mutex
+static int g_unbuffered_dropped = 0;       // Guarded by g_trace_mutex, events with no buffer left
+static char g_default_path[1024] = {0};
+
+static TRACE_THREAD_LOCAL TraceBuffer *t_buffer = NULL;
+static TRACE_THREAD_LOCAL int t_generation = 0;
+
+bool trace_init(void) {
+    if (utils_atomic_read_bool(&g_enabled)) {
+        return true;
+    }
+
+    if (!g_trace_mutex) {
+        g_trace_mutex = utils_mutex_create();
+        if (!g_trace_mutex) {
+            return false;
+        }
+    }
+
+    utils_atomic_write_int(&g_generation, utils_atomic_read_int(&g_generation) + 1);
+    utils_atomic_write_bool(&g_enabled, true);
+    const char *path = trace_default_path();
+    log_info("⏱️  Latency tracing enabled, trace is written to %s", path ? path : "(no config dir)");
+    return true;
+}
+
+void trace_cleanup(void) {
+    if (!g_trace_mutex) {
+        return;
+    }
+    utils_atomic_write_bool(&g_enabled, false);
+
+    utils_mutex_lock(g_trace_mutex);
+    while (g_buffers) {
+        TraceBuffer *next = g_buffers->next;
+        free(g_buffers);
+        g_buffers = next;
+    }
+    g_free_buffers = NULL;
+    g_thread_count = 0;
+    g_unbuffered_dropped = 0;
+    utils_mutex_unlock(g_trace_mutex);
+}
+
+bool trace_is_enabled(void) {
+    return utils_atomic_read_bool(&g_enabled);
+}
+
+// This thread's buffer on first use, a free one with room left or a new one. NULL once
+// TRACE_MAX_BUFFERS are taken or full, the event is counted as dropped.
+static TraceBuffer *thread_buffer(void) {
+    int generation = utils_atomic_read_int(&g_generation);
+    if (t_buffer && t_generation == generation) {
+        return t_buffer;
+    }
+
+    utils_mutex_lock(g_trace_mutex);
+    TraceBuffer *buffer = NULL;
+    while (g_free_buffers && !buffer) {
+        TraceBuffer *free_buffer = g_free_buffers;
+        g_free_buffers = free_buffer->next_free;
+        if (free_buffer->count < TRACE_EVENTS_PER_THREAD) {
+            buffer = free_buffer; // Full ones stay on g_buffers for the dump only
+        }
+    }
+    if (!buffer && g_thread_count < TRACE_MAX_BUFFERS) {
+        buffer = (TraceBuffer *) calloc(1, sizeof(TraceBuffer));
+        if (buffer) {
+            buffer->tid = ++g_thread_count;
+            buffer->next = g_buffers;
+            g_buffers = buffer;
+        }
+    }
+    if (!buffer) {
+        g_unbuffered_dropped++;
+    }
+    utils_mutex_unlock(g_trace_mutex);
+
+    t_buffer = buffer;
+    t_generation = generation;
+    return buffer;
+}
+
+void trace_thread_exit(void) {
+    TraceBuffer *buffer = t_buffer;
+    t_buffer = NULL;
+    if (!buffer || t_generation != utils_atomic_read_int(&g_generation) || !g_trace_mutex) {
+        return; // Never traced, or the buffer went with trace_cleanup
+    }
+
+    utils_mutex_lock(g_trace_mutex);
+    buffer->next_free = g_free_buffers;
+    g_free_buffers = buffer;
+    utils_mutex_unlock(g_trace_mutex);
+}
+
+static void record(const char *name, double start, double end) {
+    if (!utils_atomic_read_bool(&g_enabled)) {
+        return;
+    }
+
+    TraceBuffer *buffer = thread_buffer();
+    if (!buffer) {
+        return;
+    }
+
+    int count = buffer->count; // Only this thread writes count
+    if (count >= TRACE_EVENTS_PER_THREAD) {
+        utils_atomic_write_int(&buffer->dropped, buffer->dropped + 1);
+        return;
+    }
+    buffer->events[count].name = name;
+    buffer->events[count].start = start;
+    buffer->events[count].end = end;
+    utils_atomic_write_int(&buffer->count, count + 1);
+}
+
+void trace_span(const char *name, double start, double end) {
+    record(name, start, end < start ? start : end);
+}
+
+void trace_instant(const char *name, double time) {
+    record(name, time, -1.0);
+}
+
+static void write_name(FILE *file, const char *name) {
+    for (const char *c = name; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+}
+
+bool trace_dump(const char *path) {
+    if (!utils_atomic_read_bool(&g_enabled) || !path) {
+        return false;
+    }
+
+    FILE *file = utils_fopen_write(path);
+    if (!file) {
+        log_error("Failed to write trace to %s", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"yakety\"}}");
+
+    int n_events = 0;
+    int n_dropped = 0;
+    utils_mutex_lock(g_trace_mutex);
+    for (TraceBuffer *buffer = g_buffers; buffer; buffer = buffer->next) {
+        int count = utils_atomic_read_int(&buffer->count);
+        for (int i = 0; i < count; i++) {
+            const TraceEvent *event = &buffer->events[i];
+            fprintf(file, ",\n{\"name\":\"");
+            write_name(file, event->name);
+            if (event->end < 0) {
+                fprintf(file, "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.1f,\"pid\":1,\"tid\":%d}", event->start * 1e6,
+                        buffer->tid);
+            } else {
+                fprintf(file, "\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%d}", event->start * 1e6,
+                        (event->end - event->start) * 1e6, buffer->tid);
+            }
+        }
+        n_events += count;
+        n_dropped += utils_atomic_read_int(&buffer->dropped);
+    }
+    n_dropped += g_unbuffered_dropped;
+    utils_mutex_unlock(g_trace_mutex);
+
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    if (ok) {
+        log_info("⏱️  Wrote %d trace events to %s (%d dropped)", n_events, path, n_dropped);
+    }
+    return ok;
+}
+
+const char *trace_default_path(void) {
+    if (g_default_path[0] == '\0') {
+        const char *dir = utils_get_config_dir();
+        if (!dir) {
+            return NULL;
+        }
+        snprintf(g_default_path, sizeof(g_default_path), "%s%cyakety-trace.json", dir,
+#ifdef _WIN32
+                 '\\'
+#else
+                 '/'
+#endif
+        );
+    }
+    return g_default_path;
+}
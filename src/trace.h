@@ -0,0 +1,39 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Latency tracing - spans of the dictation pipeline (key down to paste) written as Chrome
+// trace_event JSON, viewable in chrome://tracing or ui.perfetto.dev.
+// Events go into a per-thread buffer without locking. The first event on a thread takes a buffer,
+// later ones never block. Recording is a no-op unless tracing is enabled.
+
+// Enable tracing. Safe to call more than once.
+bool trace_init(void);
+// Disable tracing and free all buffers. Call once no other thread records anymore.
+void trace_cleanup(void);
+bool trace_is_enabled(void);
+
+// Record a span or instant. Times are utils_now() seconds. name is stored by pointer and must
+// stay valid until the trace is dumped (use string literals).
+void trace_span(const char *name, double start, double end);
+void trace_instant(const char *name, double time);
+
+// Hand this thread's buffer, events included, to the next thread that records. Call it at the end
+// of threads started per recording or per reload, a no-op if the thread never recorded.
+void trace_thread_exit(void);
+
+// Write everything recorded so far. Returns false if tracing is off or the file couldn't be written.
+bool trace_dump(const char *path);
+// <config dir>/yakety-trace.json
+const char *trace_default_path(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
@@ -1,4 +1,4 @@
-#include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,163 +6,354 @@
 #include "logging.h"
 #include "transcription.h"
 #include "utils.h"
+#include "vad.h"
+#include "wav.h"
+#include "wer.h"
 
-// Simple WAV file reader
+#define BENCH_DEFAULT_RUNS 5
+#define SWEEP_MAX_VALUES 16
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+// Compare the full and short-utterance inference profiles on the same clip: latency over
+// several runs after a warm-up, and accuracy against a reference transcript (or the full profile's output)
+static int run_benchmark(const WavFile *wav, int runs, const char *reference) {
+    const struct {
+        const char *name;
+        TranscriptionProfile profile;
+    } profiles[] = {
+        {"full", TRANSCRIPTION_PROFILE_FULL},
+        {"short", TRANSCRIPTION_PROFILE_SHORT},
+    };
+    const int n_profiles = (int) (sizeof(profiles) / sizeof(profiles[0]));
+
+    double audio_duration_sec = (double) wav->sample_count / wav->sample_rate;
+    double *times = (double *) malloc(runs * sizeof(double));
+    char *full_text = NULL;
+    if (!times) {
+        return 1;
+    }
+
+    printf("\n=== BENCHMARK (%d runs per profile, %.2f s of audio) ===\n", runs, audio_duration_sec);
+    printf("%-8s %10s %10s %8s %8s  %s\n", "profile", "median ms", "min ms", "RTF", "WER", "text");
+
+    for (int p = 0; p < n_profiles; p++) {
+        transcription_set_profile(profiles[p].profile);
+
+        // Warm-up run, also provides the text
+        char *text = transcription_process(wav->samples, wav->sample_count, wav->sample_rate);
+        if (!text) {
+            printf("Error: Transcription failed with %s profile\n", profiles[p].name);
+            free(times);
+            free(full_text);
+            return 1;
+        }
+
+        for (int i = 0; i < runs; i++) {
+            double start = utils_now();
+            free(transcription_process(wav->samples, wav->sample_count, wav->sample_rate));
+            times[i] = (utils_now() - start) * 1000.0;
+        }
+        qsort(times, runs, sizeof(double), compare_doubles);
+
+        double median = times[runs / 2];
+        const char *expected = reference ? reference : (full_text ? full_text : text);
+        printf("%-8s %10.1f %10.1f %8.3f %7.1f%%  \"%s\"\n", profiles[p].name, median, times[0],
+               median / 1000.0 / audio_duration_sec, word_error_rate(expected, text) * 100.0, text);
+
+        if (profiles[p].profile == TRANSCRIPTION_PROFILE_FULL) {
+            full_text = text;
+        } else {
+            free(text);
+        }
+    }
+
+    if (!reference) {
+        printf("(WER measured against the full profile, pass --reference for ground truth)\n");
+    }
+
+    transcription_set_profile(TRANSCRIPTION_PROFILE_AUTO);
+    free(full_text);
+    free(times);
+    return 0;
+}
+
+// One dimension of the sweep grid
 typedef struct {
-    uint32_t sample_rate;
-    uint16_t channels;
-    uint16_t bits_per_sample;
-    uint32_t data_size;
-    float *samples;
-    int sample_count;
-} WavFile;
-
-static int read_wav_file(const char *filename, WavFile *wav) {
-    FILE *file = utils_fopen_read_binary(filename);
-    if (!file) {
-        log_error("ERROR: Could not open file: %s\n", filename);
-        return -1;
-    }
-
-    // Read RIFF header
-    char riff[4];
-    uint32_t file_size;
-    char wave[4];
-
-    if (fread(riff, 1, 4, file) != 4 ||
-        fread(&file_size, 4, 1, file) != 1 ||
-        fread(wave, 1, 4, file) != 4) {
-        log_error("ERROR: Failed to read WAV header\n");
-        fclose(file);
-        return -1;
-    }
-
-    if (strncmp(riff, "RIFF", 4) != 0 || strncmp(wave, "WAVE", 4) != 0) {
-        log_error("ERROR: Not a valid WAV file\n");
-        fclose(file);
-        return -1;
-    }
-
-    // Read chunks
-    uint16_t format_tag = 0;
-    wav->channels = 0;
-    wav->sample_rate = 0;
-    wav->bits_per_sample = 0;
-    wav->data_size = 0;
-
-    while (!feof(file)) {
-        char chunk_id[4];
-        uint32_t chunk_size;
-
-        if (fread(chunk_id, 1, 4, file) != 4)
-            break;
-        if (fread(&chunk_size, 4, 1, file) != 1)
-            break;
-
-        if (strncmp(chunk_id, "fmt ", 4) == 0) {
-            if (fread(&format_tag, 2, 1, file) != 1 ||
-                fread(&wav->channels, 2, 1, file) != 1 ||
-                fread(&wav->sample_rate, 4, 1, file) != 1) {
-                log_error("ERROR: Failed to read fmt chunk\n");
-                fclose(file);
-                return -1;
-            }
-            fseek(file, 6, SEEK_CUR); // skip byte_rate and block_align
-            if (fread(&wav->bits_per_sample, 2, 1, file) != 1) {
-                log_error("ERROR: Failed to read bits_per_sample\n");
-                fclose(file);
-                return -1;
-            }
-            fseek(file, chunk_size - 16, SEEK_CUR); // skip rest of fmt chunk
-        } else if (strncmp(chunk_id, "data", 4) == 0) {
-            wav->data_size = chunk_size;
-
-            // Allocate buffer for samples
-            int bytes_per_sample = wav->bits_per_sample / 8;
-            wav->sample_count = wav->data_size / bytes_per_sample / wav->channels;
-            wav->samples = (float *) malloc(wav->sample_count * sizeof(float));
-
-            if (!wav->samples) {
-                log_error("ERROR: Failed to allocate memory for samples\n");
-                fclose(file);
-                return -1;
+    int values[SWEEP_MAX_VALUES];
+    int count;
+} SweepAxis;
+
+typedef struct {
+    SweepAxis threads;
+    SweepAxis flash_attn;
+    SweepAxis beam_size; // 1 = greedy
+    SweepAxis audio_ctx; // -1 = chosen by the profile, 0 = full window
+    SweepAxis vad;
+} SweepGrid;
+
+// Comma-separated integers, "auto" is -1, "full" and "off" are 0, "on" is 1
+static bool parse_axis(const char *spec, SweepAxis *axis) {
+    axis->count = 0;
+    while (*spec) {
+        const char *end = strchr(spec, ',');
+        size_t len = end ? (size_t) (end - spec) : strlen(spec);
+        char token[32];
+        if (len == 0 || len >= sizeof(token) || axis->count == SWEEP_MAX_VALUES) {
+            return false;
+        }
+        memcpy(token, spec, len);
+        token[len] = '\0';
+
+        int value;
+        if (strcmp(token, "auto") == 0) {
+            value = -1;
+        } else if (strcmp(token, "full") == 0 || strcmp(token, "off") == 0) {
+            value = 0;
+        } else if (strcmp(token, "on") == 0) {
+            value = 1;
+        } else {
+            char *number_end = NULL;
+            value = (int) strtol(token, &number_end, 10);
+            if (*number_end != '\0' || value < 0) {
+                return false;
             }
+        }
+        axis->values[axis->count++] = value;
+        spec += len + (end ? 1 : 0);
+    }
+    return axis->count > 0;
+}
 
-            // Read and convert samples to float
-            if (format_tag == 3 && wav->bits_per_sample == 32) {
-                // 32-bit float
-                for (int i = 0; i < wav->sample_count; i++) {
-                    float sample_sum = 0.0f;
-                    for (int ch = 0; ch < wav->channels; ch++) {
-                        float sample;
-                        if (fread(&sample, 4, 1, file) != 1) {
-                            log_error("ERROR: Failed to read sample data\n");
-                            free(wav->samples);
-                            fclose(file);
-                            return -1;
+static void set_axis(SweepAxis *axis, const int *values, int count) {
+    memcpy(axis->values, values, count * sizeof(int));
+    axis->count = count;
+}
+
+// Powers of two up to the core count, and the core count itself
+static void default_thread_axis(SweepAxis *axis) {
+    int cpus = utils_get_cpu_count();
+    axis->count = 0;
+    for (int n = 1; n < cpus && axis->count < SWEEP_MAX_VALUES - 1; n *= 2) {
+        axis->values[axis->count++] = n;
+    }
+    axis->values[axis->count++] = cpus;
+}
+
+static void write_csv_text(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"') {
+            fputc('"', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+// Run every combination of the grid on one clip and write a CSV row per configuration. Flash
+// attention is a context setting, so the model is reloaded for each of its values.
+static int run_sweep(const char *model_path, const WavFile *wav, int runs, const SweepGrid *grid, FILE *out) {
+    double audio_duration_sec = (double) wav->sample_count / wav->sample_rate;
+    double *times = (double *) malloc(runs * sizeof(double));
+    if (!times) {
+        return 1;
+    }
+
+    int n_configs = grid->threads.count * grid->flash_attn.count * grid->beam_size.count * grid->audio_ctx.count *
+                    grid->vad.count;
+    fprintf(stderr, "=== SWEEP (%d configurations, %d runs each, %.2f s of audio) ===\n", n_configs, runs,
+            audio_duration_sec);
+    fprintf(out, "threads,flash_attn,sampling,beam_size,audio_ctx,vad,median_ms,min_ms,max_ms,rtf,"
+                 "vad_ms,encode_ms,decode_ms,tokens,text\n");
+
+    int config = 0;
+    int failures = 0;
+    for (int f = 0; f < grid->flash_attn.count; f++) {
+        bool flash_attn = grid->flash_attn.values[f] != 0;
+        transcription_set_flash_attn(flash_attn);
+        if (transcription_init(model_path) != 0) {
+            fprintf(stderr, "Error: Failed to load model with flash attention %s\n", flash_attn ? "on" : "off");
+            failures++;
+            continue;
+        }
+        transcription_set_language("auto");
+
+        for (int t = 0; t < grid->threads.count; t++) {
+            transcription_set_pool(1, grid->threads.values[t]);
+            for (int b = 0; b < grid->beam_size.count; b++) {
+                for (int a = 0; a < grid->audio_ctx.count; a++) {
+                    for (int v = 0; v < grid->vad.count; v++) {
+                        TranscriptionTuning tuning = {grid->beam_size.values[b], grid->audio_ctx.values[a],
+                                                      grid->vad.values[v] != 0};
+                        transcription_set_tuning(&tuning);
+                        config++;
+
+                        // Warm-up run, also provides the text
+                        TranscriptionResult warmup =
+                            transcription_run(wav->samples, wav->sample_count, wav->sample_rate, NULL, NULL, NULL);
+                        if (!warmup.text) {
+                            fprintf(stderr, "[%d/%d] transcription failed, skipped\n", config, n_configs);
+                            failures++;
+                            continue;
                         }
-                        sample_sum += sample;
-                    }
-                    wav->samples[i] = sample_sum / wav->channels;
-                }
-            } else if (format_tag == 1 && wav->bits_per_sample == 16) {
-                // 16-bit PCM
-                for (int i = 0; i < wav->sample_count; i++) {
-                    float sample_sum = 0.0f;
-                    for (int ch = 0; ch < wav->channels; ch++) {
-                        int16_t sample;
-                        if (fread(&sample, 2, 1, file) != 1) {
-                            log_error("ERROR: Failed to read sample data\n");
-                            free(wav->samples);
-                            fclose(file);
-                            return -1;
+
+                        TranscriptionTimings sum = {0};
+                        for (int i = 0; i < runs; i++) {
+                            double start = utils_now();
+                            TranscriptionResult run =
+                                transcription_run(wav->samples, wav->sample_count, wav->sample_rate, NULL, NULL, NULL);
+                            times[i] = (utils_now() - start) * 1000.0;
+                            sum.vad_ms += run.timings.vad_ms;
+                            sum.encode_ms += run.timings.encode_ms;
+                            sum.decode_ms += run.timings.decode_ms;
+                            sum.n_sampled_tokens += run.timings.n_sampled_tokens;
+                            free(run.text);
+                        }
+                        qsort(times, runs, sizeof(double), compare_doubles);
+                        double median = times[runs / 2];
+
+                        char audio_ctx[16];
+                        if (tuning.audio_ctx < 0) {
+                            snprintf(audio_ctx, sizeof(audio_ctx), "auto");
+                        } else if (tuning.audio_ctx == 0) {
+                            snprintf(audio_ctx, sizeof(audio_ctx), "full");
+                        } else {
+                            snprintf(audio_ctx, sizeof(audio_ctx), "%d", tuning.audio_ctx);
                         }
-                        sample_sum += (float) sample / 32768.0f;
+                        fprintf(out, "%d,%d,%s,%d,%s,%d,%.1f,%.1f,%.1f,%.4f,%.1f,%.1f,%.1f,%.1f,",
+                                grid->threads.values[t], flash_attn, tuning.beam_size > 1 ? "beam" : "greedy",
+                                tuning.beam_size, audio_ctx, tuning.vad, median, times[0], times[runs - 1],
+                                median / 1000.0 / audio_duration_sec, sum.vad_ms / runs, sum.encode_ms / runs,
+                                sum.decode_ms / runs, (double) sum.n_sampled_tokens / runs);
+                        write_csv_text(out, warmup.text);
+                        fputc('\n', out);
+                        fflush(out);
+                        free(warmup.text);
+
+                        fprintf(stderr, "[%d/%d] threads=%d flash_attn=%d beam=%d audio_ctx=%s vad=%d: %.1f ms\n",
+                                config, n_configs, grid->threads.values[t], flash_attn, tuning.beam_size, audio_ctx,
+                                tuning.vad, median);
                     }
-                    wav->samples[i] = sample_sum / wav->channels;
                 }
-            } else {
-                log_error("ERROR: Unsupported WAV format (format=%d, bits=%d)\n", format_tag, wav->bits_per_sample);
-                free(wav->samples);
-                fclose(file);
-                return -1;
             }
-
-            break; // Done reading
-        } else {
-            // Skip unknown chunk
-            fseek(file, chunk_size, SEEK_CUR);
         }
+        transcription_cleanup();
     }
 
-    fclose(file);
-
-    if (wav->sample_count == 0) {
-        log_error("ERROR: No audio data found in file\n");
-        return -1;
-    }
+    transcription_set_tuning(NULL);
+    transcription_set_flash_attn(true);
+    free(times);
+    return failures > 0 ? 1 : 0;
+}
 
-    log_info("📊 WAV file info: %d Hz, %d channels, %d bits, %d samples\n", wav->sample_rate, wav->channels,
-             wav->bits_per_sample, wav->sample_count);
+// --stats: process RSS around the model load, to compare models before picking one for a machine.
+// whisper doesn't expose its buffer sizes, and nothing else loads meanwhile in this tool.
+static void print_memory_stats(size_t rss_before_load, size_t rss_after_load) {
+    const double mb = 1024.0 * 1024.0;
+    TranscriptionMemoryStats stats;
+    transcription_get_memory_stats(&stats);
+
+    printf("\n=== MEMORY ===\n");
+    printf("RSS growth loading the model: %.1f MB\n",
+           rss_after_load > rss_before_load ? (rss_after_load - rss_before_load) / mb : 0.0);
+    printf("Whisper states created: %d of %d\n", stats.n_created, stats.n_states);
+    printf("Process RSS: %.1f MB (peak RSS %.1f MB)\n", utils_get_rss() / mb, utils_get_peak_rss() / mb);
+}
 
-    return 0;
+static void print_usage(const char *program) {
+    printf("Usage: %s [options] <audio_file.wav> [model_path]\n", program);
+    printf("Options:\n");
+    printf("  --bench               Compare full and short-utterance inference profiles\n");
+    printf("  --runs <n>            Timed runs per profile in benchmark mode (default %d)\n", BENCH_DEFAULT_RUNS);
+    printf("  --reference <text>    Reference transcript for word error rate in benchmark mode\n");
+    printf("  --sweep               Time every combination of the settings below, write CSV\n");
+    printf("  --threads <list>      Threads to sweep (default: powers of two up to the core count)\n");
+    printf("  --flash-attn <list>   Flash attention on/off to sweep (default: on,off)\n");
+    printf("  --beam-size <list>    Beam sizes to sweep, 1 samples greedily (default: 1,5)\n");
+    printf("  --audio-ctx <list>    Encoder windows to sweep: auto, full or positions (default: auto,full)\n");
+    printf("  --vad <list>          VAD on/off to sweep (default: on,off)\n");
+    printf("  --output <file>       Write the sweep CSV to a file instead of stdout\n");
+    printf("  --stats               Report the process RSS, before and after loading the model\n");
+    printf("Example: %s ./out.wav\n", program);
+    printf("Example: %s ./out.wav /path/to/ggml-model.bin\n", program);
+    printf("Example: %s --bench --reference \"hello world\" ./out.wav\n", program);
+    printf("Example: %s --sweep --threads 4,8,16 --beam-size 1 --output sweep.csv ./out.wav\n", program);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Usage: %s <audio_file.wav> [model_path]\n", argv[0]);
-        printf("Example: %s ./out.wav\n", argv[0]);
-        printf("Example: %s ./out.wav /path/to/ggml-model.bin\n", argv[0]);
-        return 1;
+    const char *audio_file = NULL;
+    const char *model_path = NULL;
+    const char *reference = NULL;
+    const char *output_path = NULL;
+    bool bench = false;
+    bool sweep = false;
+    bool stats = false;
+    int runs = BENCH_DEFAULT_RUNS;
+
+    SweepGrid grid;
+    const int on_off[] = {1, 0};
+    const int beam_sizes[] = {1, 5};
+    const int audio_ctxs[] = {-1, 0};
+    default_thread_axis(&grid.threads);
+    set_axis(&grid.flash_attn, on_off, 2);
+    set_axis(&grid.beam_size, beam_sizes, 2);
+    set_axis(&grid.audio_ctx, audio_ctxs, 2);
+    set_axis(&grid.vad, on_off, 2);
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        SweepAxis *axis = NULL;
+        if (strcmp(argv[i], "--threads") == 0) {
+            axis = &grid.threads;
+        } else if (strcmp(argv[i], "--flash-attn") == 0) {
+            axis = &grid.flash_attn;
+        } else if (strcmp(argv[i], "--beam-size") == 0) {
+            axis = &grid.beam_size;
+        } else if (strcmp(argv[i], "--audio-ctx") == 0) {
+            axis = &grid.audio_ctx;
+        } else if (strcmp(argv[i], "--vad") == 0) {
+            axis = &grid.vad;
+        }
+
+        if (axis) {
+            if (!has_value || !parse_axis(argv[++i], axis)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = true;
+        } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--runs") == 0 && has_value) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reference") == 0 && has_value) {
+            reference = argv[++i];
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else if (!audio_file) {
+            audio_file = argv[i];
+        } else if (!model_path) {
+            model_path = argv[i];
+        }
     }
 
-    const char *audio_file = argv[1];
-    const char *model_path = NULL;
+    if (!audio_file || runs < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
 
     // Check if model path was provided as second argument
-    if (argc >= 3) {
-        model_path = argv[2];
-    } else {
+    if (!model_path) {
         // Get default model path
         model_path = utils_get_model_path();
         if (!model_path) {
@@ -171,6 +362,34 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Sweep mode loads the model once per flash attention setting and keeps stdout for the CSV
+    if (sweep) {
+        WavFile wav = {0};
+        if (wav_read(audio_file, &wav) != 0) {
+            fprintf(stderr, "Error: Failed to read WAV file\n");
+            return 1;
+        }
+        FILE *out = output_path ? utils_fopen_write(output_path) : stdout;
+        if (!out) {
+            fprintf(stderr, "Error: Could not write %s\n", output_path);
+            free(wav.samples);
+            return 1;
+        }
+
+        vad_setup();
+        const char *vad_model_path = utils_get_vad_model_path();
+        if (vad_model_path && vad_init(vad_model_path) != 0) {
+            fprintf(stderr, "Warning: Failed to load VAD model, vad=1 rows run without it\n");
+        }
+        int sweep_result = run_sweep(model_path, &wav, runs, &grid, out);
+        if (out != stdout) {
+            fclose(out);
+        }
+        free(wav.samples);
+        vad_cleanup();
+        return sweep_result;
+    }
+
     printf("=== Whisper Transcription Performance Test ===\n");
     printf("Audio file: %s\n", audio_file);
 
@@ -180,21 +399,30 @@ int main(int argc, char *argv[]) {
     printf("Loading model...\n");
     double model_load_start = utils_now();
 
+    size_t rss_before_load = utils_get_rss();
     if (transcription_init(model_path) != 0) {
         printf("Error: Failed to initialize transcription\n");
         return 1;
     }
+    size_t rss_after_load = utils_get_rss();
 
     transcription_set_language("auto");
 
+    vad_setup();
+    const char *vad_model_path = utils_get_vad_model_path();
+    if (vad_model_path && vad_init(vad_model_path) != 0) {
+        printf("Warning: Failed to load VAD model, transcribing without it\n");
+    }
+
     double model_load_time = utils_now() - model_load_start;
     printf("Model loaded in %.2f ms\n", model_load_time * 1000.0);
 
     // Read WAV file
     WavFile wav = {0};
-    if (read_wav_file(audio_file, &wav) != 0) {
+    if (wav_read(audio_file, &wav) != 0) {
         printf("Error: Failed to read WAV file\n");
         transcription_cleanup();
+        vad_cleanup();
         return 1;
     }
 
@@ -203,10 +431,22 @@ int main(int argc, char *argv[]) {
     printf("Audio duration: %.2f seconds (%d samples at %d Hz)\n", audio_duration_sec, wav.sample_count,
            wav.sample_rate);
 
+    if (bench) {
+        int bench_result = run_benchmark(&wav, runs, reference);
+        if (stats) {
+            print_memory_stats(rss_before_load, rss_after_load);
+        }
+        free(wav.samples);
+        transcription_cleanup();
+        vad_cleanup();
+        return bench_result;
+    }
+
     // Transcribe audio
     printf("Starting transcription...\n");
     double transcribe_start = utils_now();
-    char *result = transcription_process(wav.samples, wav.sample_count, wav.sample_rate);
+    TranscriptionResult run = transcription_run(wav.samples, wav.sample_count, wav.sample_rate, NULL, NULL, NULL);
+    char *result = run.text;
     double transcribe_time = utils_now() - transcribe_start;
 
     if (result) {
@@ -214,6 +454,12 @@ int main(int argc, char *argv[]) {
         printf("Transcription: \"%s\"\n", result);
         printf("Transcription time: %.2f ms (%.3f seconds)\n", transcribe_time * 1000.0, transcribe_time);
 
+        const TranscriptionTimings *t = &run.timings;
+        printf("Stages: VAD %.1f ms, mel %.1f ms, encode %.1f ms, decode %.1f ms, post-processing %.1f ms\n",
+               t->vad_ms, t->mel_ms, t->encode_ms, t->decode_ms, t->postprocess_ms);
+        printf("Tokens: %d sampled in %d decoder pass(es) over %d window(s), %d output\n", t->n_sampled_tokens,
+               t->n_decode_passes, t->n_windows, t->n_output_tokens);
+
         // Calculate real-time factor
         double rtf = transcribe_time / audio_duration_sec;
         printf("Real-time factor: %.2fx %s\n", rtf, rtf < 1.0 ? "(FASTER than real-time)" : "(SLOWER than real-time)");
@@ -233,10 +479,14 @@ int main(int argc, char *argv[]) {
 
     double total_time = utils_now() - start_time;
     printf("Total time: %.2f ms\n", total_time * 1000.0);
+    if (stats) {
+        print_memory_stats(rss_before_load, rss_after_load);
+    }
 
     // Cleanup
     free(wav.samples);
     transcription_cleanup();
+    vad_cleanup();
 
     return 0;
 }
\ No newline at end of file
@@ -4,21 +4,91 @@ extern "C" {
 #include "utils.h"
 #include "preferences.h"
 #include "models.h"
+#include "vad.h"
+#include "mel.h"
+#include "trace.h"
 }
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
 #include <vector>
 #include <fstream>
 #include <thread>
 #include "whisper.h"
 #include "../whisper.cpp/ggml/include/ggml.h"
 
-static struct whisper_context *ctx = NULL;
-static utils_mutex_t *ctx_mutex = NULL;  // Thread safety for transcription context
+#define MAX_STATES TRANSCRIPTION_MAX_STATES
+#define STATE_WAIT_MS 5
+
+// Speech-free fast path: anything shorter or quieter than this skips inference
+#define MIN_SPEECH_SAMPLES (WHISPER_SAMPLE_RATE / 10)  // 100 ms
+#define SILENCE_RMS_THRESHOLD 0.003f                    // Loudest 20 ms frame below about -50 dBFS
+
+// Short-utterance profile: the encoder normally processes a full 30 s window (1500 positions)
+#define SHORT_CLIP_SAMPLES (WHISPER_SAMPLE_RATE * 10)
+#define SAMPLES_PER_AUDIO_CTX 320      // One encoder position per 20 ms
+#define SHORT_AUDIO_CTX_MARGIN 64      // Headroom so the last word isn't cut off
+#define SHORT_MIN_TOKENS 32
+#define SHORT_TOKENS_PER_SECOND 8      // Well above normal speaking rate
+
+#define VAD_MAX_SEGMENTS 256
+#define VAD_SEGMENT_GAP_SAMPLES (WHISPER_SAMPLE_RATE / 10)  // 100 ms of silence between speech segments
+
+// Model weights are loaded once into ctx; each concurrent transcription decodes on its own
+// whisper_state from the pool so clips don't serialize on a single context
+typedef struct {
+	struct whisper_state *state;
+	bool busy;
+} StateSlot;
+
+typedef struct {
+	struct whisper_context *ctx;
+	StateSlot states[MAX_STATES];
+	int busy_count;
+} WhisperModel;
+
+// A state taken from a model's pool by acquire_state
+typedef struct {
+	WhisperModel *model;
+	int slot;
+} AcquiredState;
+
+// transcription_swap replaces g_model while it keeps serving. The replaced model stays alive as
+// g_retired until the transcriptions still running on it finish.
+static WhisperModel *g_model = NULL;
+static WhisperModel *g_retired = NULL;
+static utils_mutex_t *ctx_mutex = NULL;  // Thread safety for the models and their state pools
 static char g_language[16] = "en";// Default to English
 
+static int g_pool_size = 1;          // Number of states allowed per model, created lazily
+static int g_threads_per_state = 0;  // 0 = split the default thread budget across busy states
+static bool g_pool_configured = false;
+
+// Why clips were short-circuited before inference
+static std::atomic<int> g_inferences(0);
+static std::atomic<int> g_skipped_too_short(0);
+static std::atomic<int> g_skipped_silent(0);
+static std::atomic<int> g_skipped_no_speech(0);
+static std::atomic<int> g_cancelled(0);
+
+static std::atomic<int> g_profile(TRANSCRIPTION_PROFILE_AUTO);
+static std::atomic<int> g_beam_size(-1);
+static std::atomic<int> g_audio_ctx(-1);
+static std::atomic<int> g_vad_override(-1);
+static std::atomic<bool> g_flash_attn(true);
+static std::atomic<int> g_thread_budget(0);
+
+// Running totals of the per-stage timings, guarded by ctx_mutex
+static TranscriptionTimingStats g_timing_stats;
+
+// Background warm-up after loading, started and joined on the thread that loads the model
+static utils_thread_t *g_warm_up_thread = NULL;
+static TranscriptionCancel g_warm_up_cancel;
+static std::atomic<bool> g_warm_up_running(false);
+static std::atomic<bool> g_warm_up_skip(false); // A recording started since transcription_cleanup
+
 // Initialize mutex on first use
 static void ensure_mutex_initialized(void) {
     if (ctx_mutex == NULL) {
@@ -34,6 +104,51 @@ static void null_log_callback(enum ggml_log_level level, const char *text, void
 	// Do nothing - suppress all whisper/ggml logs
 }
 
+// Load the weights and the first state of the pool, so the first transcription doesn't pay for it.
+// Doesn't touch the installed models. Returns NULL on failure.
+static WhisperModel *load_model(const char *model_path, bool flash_attn) {
+	WhisperModel *model = (WhisperModel *) calloc(1, sizeof(WhisperModel));
+	if (!model) {
+		return NULL;
+	}
+
+	struct whisper_context_params cparams = whisper_context_default_params();
+	cparams.flash_attn = flash_attn;
+	cparams.use_gpu = true;// Ensure GPU is enabled for Flash Attention
+
+	// Load the weights only, decoding states come from the pool
+	log_debug("About to call whisper_init_from_file_with_params_no_state - thread=%p", utils_thread_id());
+	model->ctx = whisper_init_from_file_with_params_no_state(model_path, cparams);
+	log_debug("whisper_init_from_file_with_params_no_state returned ctx=%p - thread=%p", model->ctx, utils_thread_id());
+	if (!model->ctx) {
+		log_error("ERROR: Failed to initialize Whisper from model file: %s", model_path);
+		free(model);
+		return NULL;
+	}
+
+	model->states[0].state = whisper_init_state(model->ctx);
+	if (!model->states[0].state) {
+		log_error("ERROR: Failed to create whisper state");
+		whisper_free(model->ctx);
+		free(model);
+		return NULL;
+	}
+	return model;
+}
+
+static void free_model(WhisperModel *model) {
+	if (!model) {
+		return;
+	}
+	for (int i = 0; i < MAX_STATES; i++) {
+		if (model->states[i].state) {
+			whisper_free_state(model->states[i].state);
+		}
+	}
+	whisper_free(model->ctx);
+	free(model);
+}
+
 void transcription_set_language(const char *language) {
 	ensure_mutex_initialized();
 	utils_mutex_lock(ctx_mutex);
@@ -47,6 +162,119 @@ void transcription_set_language(const char *language) {
 	utils_mutex_unlock(ctx_mutex);
 }
 
+void transcription_set_pool(int n_states, int n_threads) {
+	ensure_mutex_initialized();
+	utils_mutex_lock(ctx_mutex);
+
+	g_pool_size = n_states < 1 ? 1 : (n_states > MAX_STATES ? MAX_STATES : n_states);
+	g_threads_per_state = n_threads > 0 ? n_threads : 0;
+	g_pool_configured = true;
+
+	utils_mutex_unlock(ctx_mutex);
+}
+
+void transcription_set_thread_budget(int n_threads) {
+	g_thread_budget = n_threads > 0 ? n_threads : 0;
+}
+
+// Threads a single transcription would use on an idle machine
+static int default_thread_count(void) {
+	int budget = g_thread_budget;
+	if (budget > 0) {
+		return budget;
+	}
+
+	// Use optimal number of threads (leave some for system)
+	int n_threads = std::thread::hardware_concurrency();
+	if (n_threads > 1) {
+		n_threads = std::min(n_threads - 1, 8);// Leave one core for system, cap at 8
+	} else {
+		n_threads = 4;// Default fallback
+	}
+	return n_threads;
+}
+
+int transcription_get_thread_budget(void) {
+	return default_thread_count();
+}
+
+// Take an idle state from the current model's pool, creating one if the pool isn't full yet. Waits
+// while all states are busy. Returns false if whisper isn't initialized, no state could be created
+// or the transcription was cancelled while waiting.
+static bool acquire_state(AcquiredState *acquired, int *n_threads, char *language, size_t language_size,
+						  TranscriptionCancel *cancel) {
+	for (;;) {
+		if (cancel && transcription_is_cancelled(cancel)) {
+			return false;
+		}
+
+		utils_mutex_lock(ctx_mutex);
+		WhisperModel *model = g_model;
+		if (model == NULL) {
+			utils_mutex_unlock(ctx_mutex);
+			return false;
+		}
+
+		int slot = -1;
+		for (int i = 0; i < g_pool_size && slot < 0; i++) {
+			if (!model->states[i].busy && model->states[i].state) {
+				slot = i;
+			}
+		}
+		for (int i = 0; i < g_pool_size && slot < 0; i++) {
+			if (!model->states[i].busy && !model->states[i].state) {
+				model->states[i].state = whisper_init_state(model->ctx);
+				if (model->states[i].state) {
+					log_info("🧠 Created whisper state %d of %d", i + 1, g_pool_size);
+					slot = i;
+				} else {
+					log_error("ERROR: Failed to create whisper state %d, limiting pool to %d", i + 1, i);
+					g_pool_size = i;
+				}
+			}
+		}
+
+		if (slot >= 0) {
+			model->states[slot].busy = true;
+			model->busy_count++;
+			int busy = model->busy_count + (g_retired ? g_retired->busy_count : 0);
+			*n_threads = g_threads_per_state > 0 ? g_threads_per_state : std::max(1, default_thread_count() / busy);
+			strncpy(language, g_language, language_size - 1);
+			language[language_size - 1] = '\0';
+			utils_mutex_unlock(ctx_mutex);
+			acquired->model = model;
+			acquired->slot = slot;
+			return true;
+		}
+
+		bool none_available = g_pool_size == 0;
+		utils_mutex_unlock(ctx_mutex);
+		if (none_available) {
+			return false;
+		}
+		utils_sleep_ms(STATE_WAIT_MS);
+	}
+}
+
+// The last transcription on a swapped-out model frees it
+static void release_state(const AcquiredState *acquired) {
+	WhisperModel *unused = NULL;
+	utils_mutex_lock(ctx_mutex);
+	WhisperModel *model = acquired->model;
+	model->states[acquired->slot].busy = false;
+	model->busy_count--;
+	if (model == g_retired && model->busy_count == 0) {
+		unused = g_retired;
+		g_retired = NULL;
+	}
+	utils_mutex_unlock(ctx_mutex);
+
+	if (unused) {
+		free_model(unused);
+		log_info("🔄 Freed the previous model after its last transcription");
+	}
+}
+
 int transcription_init(const char *model_path) {
 	ensure_mutex_initialized();
 	
@@ -62,7 +290,7 @@ int transcription_init(const char *model_path) {
 	log_debug("Acquired transcription mutex - thread=%p", utils_thread_id());
 
 	// Check if already initialized
-	if (ctx != NULL) {
+	if (g_model != NULL) {
 		log_debug("Already initialized, returning 0 - thread=%p", utils_thread_id());
 		log_info("Transcription already initialized");
 		utils_mutex_unlock(ctx_mutex);
@@ -79,37 +307,40 @@ int transcription_init(const char *model_path) {
 
 	double start = utils_now();
 
-	struct whisper_context_params cparams = whisper_context_default_params();
-
 	// Enable Flash Attention for better performance
-	cparams.flash_attn = true;
-	cparams.use_gpu = true;// Ensure GPU is enabled for Flash Attention
-
-	// Log what we're requesting
-	log_info("🔧 Requesting Flash Attention: %s, GPU: %s\n",
-			 cparams.flash_attn ? "YES" : "NO",
-			 cparams.use_gpu ? "YES" : "NO");
-
-	log_debug("About to call whisper_init_from_file_with_params - thread=%p", utils_thread_id());
-	ctx = whisper_init_from_file_with_params(model_path, cparams);
-	log_debug("whisper_init_from_file_with_params returned ctx=%p - thread=%p", ctx, utils_thread_id());
+	bool flash_attn = g_flash_attn;
+	log_info("🔧 Requesting Flash Attention: %s, GPU: YES\n", flash_attn ? "YES" : "NO");
 
-	double duration = utils_now() - start;
-
-	if (!ctx) {
+	g_model = load_model(model_path, flash_attn);
+	if (!g_model) {
 		log_debug("whisper_init failed - thread=%p", utils_thread_id());
-		log_error("ERROR: Failed to initialize Whisper from model file: %s", model_path);
 		utils_mutex_unlock(ctx_mutex);
 		return -1;
 	}
 
+	if (!g_pool_configured) {
+		g_pool_size = std::max(1, std::min(preferences_get_int("transcription_states", 2), MAX_STATES));
+		g_threads_per_state = std::max(0, preferences_get_int("transcription_threads", 0));
+	} else if (g_pool_size < 1) {
+		g_pool_size = 1;
+	}
+
+
+	// Filterbank for computing the spectrogram while recording
+	mel_init(model_path);
+
+	double duration = utils_now() - start;
+
 	log_debug("whisper_init success, about to log completion - thread=%p", utils_thread_id());
 	log_info("✅ Whisper initialized successfully (took %.0f ms)", duration * 1000.0);
-	log_info("⚡ Requested - Flash Attention: %s, GPU: %s",
-			 cparams.flash_attn ? "enabled" : "disabled",
-			 cparams.use_gpu ? "enabled" : "disabled");
+	log_info("⚡ Requested - Flash Attention: %s, GPU: enabled", flash_attn ? "enabled" : "disabled");
+	if (g_threads_per_state > 0) {
+		log_info("🧵 State pool: up to %d concurrent transcriptions, %d threads each", g_pool_size, g_threads_per_state);
+	} else {
+		log_info("🧵 State pool: up to %d concurrent transcriptions, %d threads shared", g_pool_size, default_thread_count());
+	}
 
-	// Check and log VAD status during initialization
+	// Check and log VAD status during initialization (the VAD context itself is loaded by models_load)
 	bool vad_enabled = preferences_get_bool("vad_enabled", true);
 	const char *vad_model_path = models_get_vad_path();
 	if (vad_enabled && vad_model_path) {
@@ -126,95 +357,573 @@ int transcription_init(const char *model_path) {
 }
 
 
+// Concatenate the speech segments found by VAD into speech, separated by short silences, and describe
+// where each part came from for the mel cache. Returns the number of segments, or -1 if VAD failed
+// and the whole buffer should be used.
+static int extract_speech(const float *audio_data, int n_samples, int source, std::vector<float> &speech,
+						  std::vector<MelPiece> &pieces) {
+	VadSegment segments[VAD_MAX_SEGMENTS];
+	int n_segments = vad_detect(audio_data, n_samples, segments, VAD_MAX_SEGMENTS);
+	if (n_segments <= 0 || n_segments > VAD_MAX_SEGMENTS) {
+		return n_segments > VAD_MAX_SEGMENTS ? -1 : n_segments;
+	}
+
+	speech.reserve(n_samples);
+	for (int i = 0; i < n_segments; i++) {
+		if (i > 0) {
+			pieces.push_back({(int) speech.size(), VAD_SEGMENT_GAP_SAMPLES, -1});
+			speech.insert(speech.end(), VAD_SEGMENT_GAP_SAMPLES, 0.0f);
+		}
+		pieces.push_back({(int) speech.size(), segments[i].end - segments[i].start, source + segments[i].start});
+		speech.insert(speech.end(), audio_data + segments[i].start, audio_data + segments[i].end);
+	}
+	return n_segments;
+}
+
+void transcription_set_profile(TranscriptionProfile profile) {
+	g_profile = profile;
+}
+
+void transcription_set_tuning(const TranscriptionTuning *tuning) {
+	g_beam_size = tuning ? tuning->beam_size : -1;
+	g_audio_ctx = tuning ? tuning->audio_ctx : -1;
+	g_vad_override = tuning ? tuning->vad : -1;
+}
+
+void transcription_set_flash_attn(bool enabled) {
+	g_flash_attn = enabled;
+}
+
+// Shrink the encoder window to the clip and skip what short dictations don't need:
+// timestamps, segmentation and temperature fallback (a retry re-runs the decoder)
+static void apply_short_clip_profile(struct whisper_full_params *wparams, struct whisper_context *wctx, int n_samples) {
+	int audio_ctx = n_samples / SAMPLES_PER_AUDIO_CTX + SHORT_AUDIO_CTX_MARGIN;
+	wparams->audio_ctx = std::min(audio_ctx, whisper_model_n_audio_ctx(wctx));
+	wparams->single_segment = true;
+	wparams->no_timestamps = true;
+	wparams->max_tokens = SHORT_MIN_TOKENS + (int) ((int64_t) n_samples * SHORT_TOKENS_PER_SECOND / WHISPER_SAMPLE_RATE);
+	wparams->temperature_inc = 0.0f;
+	log_info("⚡ Short-clip profile: audio_ctx=%d, max_tokens=%d\n", wparams->audio_ctx, wparams->max_tokens);
+}
+
+static bool warm_up_abort_callback(void *user_data) {
+	return transcription_is_cancelled((TranscriptionCancel *) user_data);
+}
+
+// Run a second of silence through a state of a model, so a broken model fails here and the first
+// dictation doesn't pay for the first-inference allocations, thread start-up and cold caches
+static bool warm_up(WhisperModel *model, int slot, int n_threads, TranscriptionCancel *cancel) {
+	std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+	struct whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+	wparams.print_realtime = false;
+	wparams.print_progress = false;
+	wparams.print_timestamps = false;
+	wparams.print_special = false;
+	wparams.language = "en";
+	wparams.n_threads = n_threads;
+	if (cancel) {
+		wparams.abort_callback = warm_up_abort_callback;
+		wparams.abort_callback_user_data = cancel;
+	}
+	apply_short_clip_profile(&wparams, model->ctx, (int) silence.size());
+	return whisper_full_with_state(model->ctx, model->states[slot].state, wparams, silence.data(), (int) silence.size()) == 0;
+}
+
+static void *warm_up_work(void *arg) {
+	(void) arg;
+	double start = utils_now();
+	AcquiredState acquired;
+	int n_threads = 0;
+	char language[16];
+	if (!acquire_state(&acquired, &n_threads, language, sizeof(language), &g_warm_up_cancel)) {
+		trace_thread_exit();
+		g_warm_up_running = false;
+		return NULL;
+	}
+	bool ok = warm_up(acquired.model, acquired.slot, n_threads, &g_warm_up_cancel);
+	release_state(&acquired);
+	trace_thread_exit();
+	g_warm_up_running = false;
+
+	if (transcription_is_cancelled(&g_warm_up_cancel)) {
+		log_info("🔥 Warm-up inference cancelled after %.0f ms", (utils_now() - start) * 1000.0);
+	} else if (ok) {
+		log_info("🔥 Warm-up inference took %.0f ms", (utils_now() - start) * 1000.0);
+	} else {
+		log_error("Warm-up inference failed");
+	}
+	return NULL;
+}
+
+void transcription_warm_up_start(void) {
+	if (g_warm_up_thread) {
+		utils_thread_join(g_warm_up_thread);
+	}
+	if (g_warm_up_skip) {
+		// The first dictation is already waiting, a warm-up would only split the threads with it
+		log_info("🔥 Skipping the warm-up, a recording started while the model loaded");
+		return;
+	}
+	transcription_cancel_init(&g_warm_up_cancel, 0);
+	g_warm_up_running = true;
+	g_warm_up_thread = utils_thread_create(warm_up_work, NULL);
+	if (!g_warm_up_thread) {
+		g_warm_up_running = false;
+	}
+}
+
+void transcription_warm_up_cancel(void) {
+	g_warm_up_skip = true;
+	transcription_cancel(&g_warm_up_cancel);
+}
+
+bool transcription_is_idle(void) {
+	if (g_warm_up_running) {
+		return false;
+	}
+	ensure_mutex_initialized();
+	utils_mutex_lock(ctx_mutex);
+	bool idle = (!g_model || g_model->busy_count == 0) && !g_retired;
+	utils_mutex_unlock(ctx_mutex);
+	return idle;
+}
+
+int transcription_swap(const char *model_path) {
+	ensure_mutex_initialized();
+	if (!model_path) {
+		log_error("ERROR: No model path provided");
+		return -1;
+	}
+
+	utils_mutex_lock(ctx_mutex);
+	bool loaded = g_model != NULL;
+	utils_mutex_unlock(ctx_mutex);
+	if (!loaded) {
+		return transcription_init(model_path);
+	}
+
+	// Load and warm up next to the current model, which keeps serving dictations meanwhile
+	log_info("🔄 Loading Whisper model in the background: %s", model_path);
+	double start = utils_now();
+	WhisperModel *model = load_model(model_path, g_flash_attn);
+	if (model && !warm_up(model, 0, default_thread_count(), NULL)) {
+		log_error("ERROR: Warm-up inference failed on %s", model_path);
+		free_model(model);
+		model = NULL;
+	}
+	if (!model) {
+		log_error("ERROR: Keeping the current model");
+		return -1;
+	}
+
+	// Clips recorded in between are checked against the filterbank's n_mel when they are decoded
+	mel_init(model_path);
+
+	utils_mutex_lock(ctx_mutex);
+	// Only one model can be retired at a time, wait for the one from the previous swap
+	while (g_retired && g_model) {
+		utils_mutex_unlock(ctx_mutex);
+		utils_sleep_ms(STATE_WAIT_MS);
+		utils_mutex_lock(ctx_mutex);
+	}
+	if (!g_model) {
+		// transcription_cleanup ran meanwhile
+		utils_mutex_unlock(ctx_mutex);
+		free_model(model);
+		return -1;
+	}
+
+	WhisperModel *old_model = g_model;
+	g_model = model;
+	bool old_busy = old_model->busy_count > 0;
+	if (old_busy) {
+		g_retired = old_model;
+	}
+	utils_mutex_unlock(ctx_mutex);
+
+	if (!old_busy) {
+		free_model(old_model);
+	}
+	log_info("🔄 Swapped to %s (took %.0f ms%s)", model_path, (utils_now() - start) * 1000.0,
+			 old_busy ? ", previous model freed after the running transcriptions" : "");
+	return 0;
+}
+
+// Count a short-circuited clip and return the same empty result as "No speech detected"
+static char *skip_inference(std::atomic<int> *counter, const char *reason) {
+	(*counter)++;
+	log_info("⚠️  Skipping inference: %s\n", reason);
+	char *empty_result = (char *) malloc(1);
+	if (empty_result) {
+		empty_result[0] = '\0';
+	}
+	return empty_result;
+}
+
+void transcription_cancel_init(TranscriptionCancel *token, double timeout_ms) {
+	utils_atomic_write_bool(&token->cancelled, false);
+	token->deadline = timeout_ms > 0 ? utils_now() + timeout_ms / 1000.0 : 0.0;
+}
+
+void transcription_cancel(TranscriptionCancel *token) {
+	if (token) {
+		utils_atomic_write_bool(&token->cancelled, true);
+	}
+}
+
+bool transcription_is_cancelled(TranscriptionCancel *token) {
+	if (utils_atomic_read_bool(&token->cancelled)) {
+		return true;
+	}
+	if (token->deadline > 0 && utils_now() > token->deadline) {
+		utils_atomic_write_bool(&token->cancelled, true);
+		return true;
+	}
+	return false;
+}
+
+// State shared by whisper's callbacks during one whisper_full call. whisper only keeps timings
+// for a context's built-in state, so the pooled states are timed at the phase boundaries instead:
+// whisper's own mel runs until the first encoder run, the decoder starts with the first logits
+// of a window (prompt processing counts as encoding) and runs until the next window is encoded.
+typedef struct {
+	TranscriptionCancel *cancel;
+	TranscriptionTimings *timings;
+	double mel_start;    // Set while whisper computes the mel itself
+	double encode_start; // Set while the encoder runs
+	double decode_start; // Set while the decoder runs
+} InferenceHooks;
+
+// Called by ggml between graph nodes, returning true aborts the computation
+static bool abort_callback(void *user_data) {
+	return transcription_is_cancelled(((InferenceHooks *) user_data)->cancel);
+}
+
+// Called before each encoder run, returning false skips it
+static bool encoder_begin_callback(struct whisper_context *, struct whisper_state *, void *user_data) {
+	InferenceHooks *hooks = (InferenceHooks *) user_data;
+	double now = utils_now();
+	if (hooks->mel_start > 0) {
+		trace_span("mel", hooks->mel_start, now);
+		hooks->timings->mel_ms += (now - hooks->mel_start) * 1000.0;
+		hooks->mel_start = 0;
+	}
+	if (hooks->decode_start > 0) {
+		trace_span("decode", hooks->decode_start, now);
+		hooks->timings->decode_ms += (now - hooks->decode_start) * 1000.0;
+		hooks->decode_start = 0;
+	}
+	hooks->encode_start = now;
+	hooks->timings->n_windows++;
+	return !(hooks->cancel && transcription_is_cancelled(hooks->cancel));
+}
+
+// Called before each sampled token, the first one after an encoder run ends encoding.
+// n_tokens is the length of the sequence so far, 0 starts a decoder pass.
+static void logits_filter_callback(struct whisper_context *, struct whisper_state *, const whisper_token_data *,
+								   int n_tokens, float *, void *user_data) {
+	InferenceHooks *hooks = (InferenceHooks *) user_data;
+	if (hooks->encode_start > 0) {
+		double now = utils_now();
+		trace_span("encode", hooks->encode_start, now);
+		hooks->timings->encode_ms += (now - hooks->encode_start) * 1000.0;
+		hooks->encode_start = 0;
+		hooks->decode_start = now;
+	}
+	if (n_tokens == 0) {
+		hooks->timings->n_decode_passes++;
+	}
+	hooks->timings->n_sampled_tokens++;
+}
+
+// Close whatever phase was running when whisper_full returned
+static void finish_inference_timing(InferenceHooks *hooks) {
+	double now = utils_now();
+	if (hooks->encode_start > 0) {
+		trace_span("encode", hooks->encode_start, now);
+		hooks->timings->encode_ms += (now - hooks->encode_start) * 1000.0;
+	}
+	if (hooks->decode_start > 0) {
+		trace_span("decode", hooks->decode_start, now);
+		hooks->timings->decode_ms += (now - hooks->decode_start) * 1000.0;
+	}
+}
+
+static char *cancel_inference(void) {
+	g_cancelled++;
+	log_info("🛑 Transcription cancelled\n");
+	return NULL;
+}
+
+void transcription_get_skip_stats(TranscriptionSkipStats *stats) {
+	if (!stats) {
+		return;
+	}
+	stats->inferences = g_inferences;
+	stats->skipped_too_short = g_skipped_too_short;
+	stats->skipped_silent = g_skipped_silent;
+	stats->skipped_no_speech = g_skipped_no_speech;
+	stats->cancelled = g_cancelled;
+}
+
+void transcription_get_memory_stats(TranscriptionMemoryStats *stats) {
+	if (!stats) {
+		return;
+	}
+	ensure_mutex_initialized();
+	memset(stats, 0, sizeof(*stats));
+	utils_mutex_lock(ctx_mutex);
+	stats->n_states = g_pool_size;
+	for (int i = 0; g_model && i < MAX_STATES; i++) {
+		if (g_model->states[i].state) {
+			stats->n_created++;
+		}
+	}
+	utils_mutex_unlock(ctx_mutex);
+}
+
+void transcription_get_timing_stats(TranscriptionTimingStats *stats) {
+	if (!stats) {
+		return;
+	}
+	ensure_mutex_initialized();
+	utils_mutex_lock(ctx_mutex);
+	*stats = g_timing_stats;
+	utils_mutex_unlock(ctx_mutex);
+}
+
+static void add_timings(TranscriptionTimings *sum, const TranscriptionTimings *timings) {
+	sum->vad_ms += timings->vad_ms;
+	sum->wait_ms += timings->wait_ms;
+	sum->mel_ms += timings->mel_ms;
+	sum->encode_ms += timings->encode_ms;
+	sum->decode_ms += timings->decode_ms;
+	sum->postprocess_ms += timings->postprocess_ms;
+	sum->total_ms += timings->total_ms;
+	sum->n_windows += timings->n_windows;
+	sum->n_decode_passes += timings->n_decode_passes;
+	sum->n_sampled_tokens += timings->n_sampled_tokens;
+	sum->n_output_tokens += timings->n_output_tokens;
+}
+
+static char *process(const float *audio_data, int n_samples, const MelCache *mel, TranscriptionCancel *cancel,
+					 const TranscriptionOptions *options, TranscriptionTimings *timings);
+
 char *transcription_process(const float *audio_data, int n_samples, int sample_rate) {
+	return transcription_run(audio_data, n_samples, sample_rate, NULL, NULL, NULL).text;
+}
+
+TranscriptionResult transcription_run(const float *audio_data, int n_samples, int sample_rate, const MelCache *mel,
+									  TranscriptionCancel *cancel, const TranscriptionOptions *options) {
 	(void) sample_rate;// Currently unused
 	ensure_mutex_initialized();
-	
+
+	TranscriptionResult result;
+	memset(&result, 0, sizeof(result));
+
 	log_debug("transcription_process() ENTRY - thread=%p", utils_thread_id());
-	
+
 	if (audio_data == NULL || n_samples <= 0) {
 		log_error("ERROR: Invalid parameters for transcription");
-		return NULL;
+		return result;
 	}
-	
-	utils_mutex_lock(ctx_mutex);
-	log_debug("Acquired transcription mutex for processing - thread=%p", utils_thread_id());
-	
-	if (ctx == NULL) {
+
+	double total_start = utils_now();
+	result.text = process(audio_data, n_samples, mel, cancel, options, &result.timings);
+	TranscriptionTimings *timings = &result.timings;
+	timings->total_ms = (utils_now() - total_start) * 1000.0;
+
+	if (timings->n_windows > 0) {
+		log_info("⏱️  Whisper stages: mel %.0f ms, encode %.0f ms, decode %.0f ms (%d windows, %d decoder passes, "
+				 "%d tokens sampled, %d output)\n",
+				 timings->mel_ms, timings->encode_ms, timings->decode_ms, timings->n_windows, timings->n_decode_passes,
+				 timings->n_sampled_tokens, timings->n_output_tokens);
+	}
+	// Cancelled and failed runs would skew the averages
+	if (timings->n_windows > 0 && result.text) {
+		utils_mutex_lock(ctx_mutex);
+		g_timing_stats.runs++;
+		add_timings(&g_timing_stats.sum, timings);
+		utils_mutex_unlock(ctx_mutex);
+	}
+	return result;
+}
+
+// The transcription itself, fills in the per-stage timings of the stages it ran
+static char *process(const float *audio_data, int n_samples, const MelCache *mel, TranscriptionCancel *cancel,
+					 const TranscriptionOptions *options, TranscriptionTimings *timings) {
+	double total_start = utils_now();
+
+	// Fast path: clips without speech never reach the encoder
+	if (n_samples < MIN_SPEECH_SAMPLES) {
+		return skip_inference(&g_skipped_too_short, "too short");
+	}
+	if (vad_peak_rms(audio_data, n_samples) < SILENCE_RMS_THRESHOLD) {
+		return skip_inference(&g_skipped_silent, "below energy threshold");
+	}
+
+	// VAD (Voice Activity Detection) runs on the persistent VAD context and only the speech is
+	// decoded, whisper's built-in VAD would reload the VAD model on every call
+	// Where the audio sits in the recording the mel cache was computed from
+	int mel_source = mel_cache_source_offset(mel, audio_data, n_samples);
+	std::vector<MelPiece> mel_pieces;
+
+	std::vector<float> speech;
+	int vad_override = options && options->vad >= 0 ? options->vad : (int) g_vad_override;
+	bool vad_enabled = vad_override >= 0 ? vad_override != 0 : preferences_get_bool("vad_enabled", true);
+	if (vad_enabled && vad_is_loaded()) {
+		double vad_start = utils_now();
+		int n_speech_segments = extract_speech(audio_data, n_samples, mel_source, speech, mel_pieces);
+		trace_span("vad", vad_start, utils_now());
+		timings->vad_ms = (utils_now() - vad_start) * 1000.0;
+		log_info("⏱️  VAD took: %.0f ms (%d speech segments, %zu of %d samples)\n", (utils_now() - vad_start) * 1000.0,
+				 n_speech_segments, speech.size(), n_samples);
+		if (n_speech_segments == 0) {
+			return skip_inference(&g_skipped_no_speech, "no speech found by VAD");
+		}
+		if (n_speech_segments > 0) {
+			audio_data = speech.data();
+			n_samples = (int) speech.size();
+		} else {
+			mel_pieces.clear();
+		}
+	} else if (!vad_enabled) {
+		log_info(vad_override >= 0 ? "VAD disabled by tuning" : "VAD disabled in preferences");
+	} else {
+		log_info("VAD model not loaded, running without voice activity detection");
+	}
+
+	int n_threads = 0;
+	char language[sizeof(g_language)];
+	double acquire_start = utils_now();
+	AcquiredState acquired;
+	bool have_state = acquire_state(&acquired, &n_threads, language, sizeof(language), cancel);
+	trace_span("wait for state", acquire_start, utils_now());
+	timings->wait_ms = (utils_now() - acquire_start) * 1000.0;
+	if (!have_state && cancel && transcription_is_cancelled(cancel)) {
+		return cancel_inference();
+	}
+	if (!have_state) {
 		log_debug("Context not available - thread=%p", utils_thread_id());
 		log_error("ERROR: Whisper not initialized");
-		utils_mutex_unlock(ctx_mutex);
 		return NULL;
 	}
+	// The model this transcription runs on, even if a swap installs another one meanwhile
+	struct whisper_context *ctx = acquired.model->ctx;
+	struct whisper_state *state = acquired.model->states[acquired.slot].state;
+	int slot = acquired.slot;
+	if (options && options->n_threads > 0) {
+		n_threads = options->n_threads;
+	}
+	log_debug("Acquired whisper state %d for processing - thread=%p", slot, utils_thread_id());
+	g_inferences++;
 
-	log_info("🧠 Transcribing %d audio samples (%.2f seconds) using language: %s\n",
-			 n_samples, (float) n_samples / 16000.0f, g_language);
-
-	double total_start = utils_now();
+	log_info("🧠 Transcribing %d audio samples (%.2f seconds) using language: %s (state %d, %d threads)\n",
+			 n_samples, (float) n_samples / 16000.0f, language, slot, n_threads);
 
 	// Set up whisper parameters
-	struct whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+	int beam_size = g_beam_size;
+	struct whisper_full_params wparams =
+		whisper_full_default_params(beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+	if (beam_size > 1) {
+		wparams.beam_search.beam_size = beam_size;
+	}
 	wparams.print_realtime = false;
 	wparams.print_progress = false;
 	wparams.print_timestamps = false;
 	wparams.print_special = false;
 	wparams.translate = false;
-	wparams.language = g_language;// Use configured language
-	// Use optimal number of threads (leave some for system)
-	int n_threads = std::thread::hardware_concurrency();
-	if (n_threads > 1) {
-		n_threads = std::min(n_threads - 1, 8);// Leave one core for system, cap at 8
-	} else {
-		n_threads = 4;// Default fallback
-	}
+	wparams.language = language;// Use configured language
 	wparams.n_threads = n_threads;
 	wparams.offset_ms = 0;
 	wparams.duration_ms = 0;
+	wparams.vad = false;// Done above on the persistent VAD context
+	InferenceHooks hooks = {cancel, timings, 0, 0, 0};
+	wparams.encoder_begin_callback = encoder_begin_callback;
+	wparams.encoder_begin_callback_user_data = &hooks;
+	wparams.logits_filter_callback = logits_filter_callback;
+	wparams.logits_filter_callback_user_data = &hooks;
+	if (cancel) {
+		wparams.abort_callback = abort_callback;
+		wparams.abort_callback_user_data = &hooks;
+	}
 
-	// Configure VAD (Voice Activity Detection)
-	bool vad_enabled = preferences_get_bool("vad_enabled", true);
-	const char *vad_model_path = models_get_vad_path();
-	if (vad_enabled && vad_model_path) {
-		wparams.vad = true;
-		wparams.vad_model_path = vad_model_path;
-		wparams.vad_params = whisper_vad_default_params();
-		log_info("VAD enabled with model: %s", vad_model_path);
-	} else {
-		wparams.vad = false;
-		if (!vad_enabled) {
-			log_info("VAD disabled in preferences");
-		} else {
-			log_info("VAD model not found, running without voice activity detection");
+	int profile = g_profile;
+	if (profile == TRANSCRIPTION_PROFILE_AUTO) {
+		bool short_clip = n_samples < SHORT_CLIP_SAMPLES && preferences_get_bool("short_clip_profile", true);
+		profile = short_clip ? TRANSCRIPTION_PROFILE_SHORT : TRANSCRIPTION_PROFILE_FULL;
+	}
+	if (profile == TRANSCRIPTION_PROFILE_SHORT) {
+		apply_short_clip_profile(&wparams, ctx, n_samples);
+	}
+	int audio_ctx = g_audio_ctx;
+	if (audio_ctx >= 0) {
+		wparams.audio_ctx = std::min(audio_ctx, whisper_model_n_audio_ctx(ctx));
+	}
+
+	// Use the log-mel spectrogram computed while recording, only the frames that weren't ready
+	// yet (or straddle a VAD cut) are computed now
+	bool mel_set = false;
+	if (mel_source >= 0) {
+		if (mel_pieces.empty()) {
+			mel_pieces.push_back({0, n_samples, mel_source});
+		}
+		double mel_start = utils_now();
+		int n_mel = whisper_model_n_mels(ctx);
+		int n_len = 0;
+		int n_reused = 0;
+		float *mel_data = mel_build(mel, audio_data, n_samples, mel_pieces.data(), (int) mel_pieces.size(), n_mel,
+									&n_len, &n_reused);
+		if (mel_data && whisper_set_mel_with_state(ctx, state, mel_data, n_len, n_mel) == 0) {
+			mel_set = true;
+			// Stop where the audio ends like whisper_pcm_to_mel does, not after the 30 s of padding
+			wparams.duration_ms = (1 + (n_samples - WHISPER_N_FFT / 2) / WHISPER_HOP_LENGTH) * 10;
 		}
+		free(mel_data);
+		trace_span("mel", mel_start, utils_now());
+		timings->mel_ms = (utils_now() - mel_start) * 1000.0;
+		log_info("⏱️  Mel spectrogram took: %.0f ms (%d frames precomputed while recording)\n",
+				 (utils_now() - mel_start) * 1000.0, n_reused);
 	}
 
 	// Run transcription
 	double whisper_start = utils_now();
-	int whisper_result = whisper_full(ctx, wparams, audio_data, n_samples);
+	hooks.mel_start = mel_set ? 0 : whisper_start;
+	int whisper_result = mel_set ? whisper_full_with_state(ctx, state, wparams, NULL, 0)
+								 : whisper_full_with_state(ctx, state, wparams, audio_data, n_samples);
 	double whisper_duration = utils_now() - whisper_start;
+	finish_inference_timing(&hooks);
 
 	log_info("⏱️  Whisper inference took: %.0f ms\n", whisper_duration * 1000.0);
 
+	if (cancel && transcription_is_cancelled(cancel)) {
+		release_state(&acquired);
+		return cancel_inference();
+	}
 	if (whisper_result != 0) {
 		log_error("ERROR: Failed to run whisper transcription\n");
+		release_state(&acquired);
 		return NULL;
 	}
+	double postprocess_start = utils_now();
 
 	// Get transcription result
-	const int n_segments = whisper_full_n_segments(ctx);
+	const int n_segments = whisper_full_n_segments_from_state(state);
 	if (n_segments == 0) {
 		log_info("⚠️  No speech detected\n");
 		char *empty_result = (char *) malloc(1);
 		if (empty_result) {
 			empty_result[0] = '\0';
 		}
+		release_state(&acquired);
 		return empty_result;
 	}
 
 	// Calculate total length needed
 	size_t total_len = 0;
 	for (int i = 0; i < n_segments; ++i) {
-		const char *text = whisper_full_get_segment_text(ctx, i);
+		timings->n_output_tokens += whisper_full_n_tokens_from_state(state, i);
+		const char *text = whisper_full_get_segment_text_from_state(state, i);
 		if (text) {
 			total_len += strlen(text);
 			if (i > 0) total_len++;// Space separator
@@ -225,13 +934,14 @@ char *transcription_process(const float *audio_data, int n_samples, int sample_r
 	char *result = (char *) malloc(total_len + 2);// +1 for null terminator, +1 for trailing space
 	if (!result) {
 		log_error("ERROR: Failed to allocate memory for transcription\n");
+		release_state(&acquired);
 		return NULL;
 	}
 
 	// Concatenate all segments
 	result[0] = '\0';
 	for (int i = 0; i < n_segments; ++i) {
-		const char *text = whisper_full_get_segment_text(ctx, i);
+		const char *text = whisper_full_get_segment_text_from_state(state, i);
 		if (text) {
 			if (strlen(result) > 0) {
 				strcat(result, " ");
@@ -270,8 +980,10 @@ char *transcription_process(const float *audio_data, int n_samples, int sample_r
 			// Clear the result - this is a non-speech token or annotation
 			result[0] = '\0';
 			log_info("✅ Filtered out non-speech token\n");
-			log_debug("Releasing transcription mutex (filtered token) - thread=%p", utils_thread_id());
-			utils_mutex_unlock(ctx_mutex);
+			log_debug("Releasing whisper state (filtered token) - thread=%p", utils_thread_id());
+			release_state(&acquired);
+			trace_span("postprocess", postprocess_start, utils_now());
+			timings->postprocess_ms = (utils_now() - postprocess_start) * 1000.0;
 			return result;
 		}
 	}
@@ -300,19 +1012,21 @@ char *transcription_process(const float *audio_data, int n_samples, int sample_r
 		strcat(result, " ");
 	}
 
+	trace_span("postprocess", postprocess_start, utils_now());
+	timings->postprocess_ms = (utils_now() - postprocess_start) * 1000.0;
 	double total_duration = utils_now() - total_start;
 
 	log_info("✅ Transcription complete: \"%s\"\n", result);
 	log_info("⏱️  Total transcription process took: %.0f ms\n", total_duration * 1000.0);
 	
-	log_debug("Releasing transcription mutex (normal completion) - thread=%p", utils_thread_id());
-	utils_mutex_unlock(ctx_mutex);
+	log_debug("Releasing whisper state (normal completion) - thread=%p", utils_thread_id());
+	release_state(&acquired);
 	return result;
 }
 
 
 int transcribe_file(const char *audio_file, char *result, size_t result_size) {
-	if (ctx == NULL) {
+	if (g_model == NULL) {
 		log_error("ERROR: Whisper not initialized\n");
 		return -1;
 	}
@@ -478,17 +1192,31 @@ int transcribe_file(const char *audio_file, char *result, size_t result_size) {
 
 void transcription_cleanup(void) {
 	ensure_mutex_initialized();
+
+	transcription_warm_up_cancel();
+	if (g_warm_up_thread) {
+		utils_thread_join(g_warm_up_thread);
+		g_warm_up_thread = NULL;
+	}
+	g_warm_up_skip = false; // Recordings from here on count against the next load's warm-up
 	
 	utils_mutex_lock(ctx_mutex);
 	
-	if (ctx != NULL) {
+	if (g_model != NULL) {
 		// Cleanup whisper context
-		struct whisper_context *old_ctx = ctx;
-		ctx = NULL;  // Set to NULL first to prevent double cleanup
-		
-		if (old_ctx != NULL) {
-			whisper_free(old_ctx);
+		WhisperModel *old_model = g_model;
+		g_model = NULL;  // Set to NULL first to prevent double cleanup and new transcriptions
+
+		// Let in-flight transcriptions finish before freeing their states, a model replaced by
+		// a swap is freed by its last one
+		while (old_model->busy_count > 0 || g_retired) {
+			utils_mutex_unlock(ctx_mutex);
+			utils_sleep_ms(STATE_WAIT_MS);
+			utils_mutex_lock(ctx_mutex);
 		}
+
+		free_model(old_model);
+		mel_cleanup();
 	}
 	
 	utils_mutex_unlock(ctx_mutex);
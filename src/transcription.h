@@ -1,19 +1,152 @@
 #ifndef TRANSCRIPTION_H
 #define TRANSCRIPTION_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int transcription_init(const char *model_path);
+// Replace the loaded model without interrupting dictation: the new model is loaded and warmed up
+// next to the current one, which keeps serving until the swap. Transcriptions already running
+// finish on the old model, it is freed after the last one. Blocks for the load, call it off the
+// main thread. On failure the current model stays loaded and -1 is returned. Loads the model like
+// transcription_init if none is loaded.
+int transcription_swap(const char *model_path);
+// Run a short inference on silence on a background thread, so the first dictation after loading
+// doesn't pay for lazily allocated compute buffers, ggml thread start-up and cold caches. Its cost
+// is logged. transcription_warm_up_cancel() stops it within one graph step, call it when a
+// recording starts so the warm-up never competes with a real dictation. A recording started since
+// transcription_cleanup (i.e. during the load) skips the warm-up altogether.
+void transcription_warm_up_start(void);
+void transcription_warm_up_cancel(void);
+// True when neither the warm-up nor any transcription is running
+bool transcription_is_idle(void);
 void transcription_cleanup(void);
 void transcription_set_language(const char *language);
+// Configure the whisper_state pool, applies to transcriptions started after the call.
+// n_states: max concurrent transcriptions on the loaded model (states are created on demand).
+// n_threads: threads per transcription, 0 splits the default budget across running transcriptions.
+// Without this call the "transcription_states" and "transcription_threads" preferences are used.
+void transcription_set_pool(int n_states, int n_threads);
+// Threads a single transcription uses on an idle machine, the default budget above. 0 restores
+// the built-in guess (cores - 1, at most 8). Set from the stored autotune result (see autotune.h).
+void transcription_set_thread_budget(int n_threads);
+// The budget set above, or the built-in guess
+int transcription_get_thread_budget(void);
+
+// Inference profile. AUTO uses the short-utterance profile (encoder window shrunk to the clip,
+// single segment, no timestamps, capped tokens, no temperature fallback) for clips under 10 s
+// unless the "short_clip_profile" preference is off.
+typedef enum {
+    TRANSCRIPTION_PROFILE_AUTO,
+    TRANSCRIPTION_PROFILE_FULL,
+    TRANSCRIPTION_PROFILE_SHORT
+} TranscriptionProfile;
+
+void transcription_set_profile(TranscriptionProfile profile);
+
+// Inference overrides for finding the right settings on a machine (transcribe --sweep), applied
+// to transcriptions started after the call. -1 keeps the default for that field.
+typedef struct {
+    int beam_size; // 1 samples greedily (the default), more switches to beam search
+    int audio_ctx; // Encoder positions, 0 for the full 30 s window. Default: chosen by the profile.
+    int vad;       // 0 or 1. Default: the "vad_enabled" preference.
+} TranscriptionTuning;
+
+// NULL restores the defaults
+void transcription_set_tuning(const TranscriptionTuning *tuning);
+// Flash attention is a context setting, applies from the next transcription_init. Default: on.
+void transcription_set_flash_attn(bool enabled);
+
 // Process audio data and return transcribed text.
 // Returns malloc'd string that caller must free, or NULL on error.
 // The returned string is cleaned (trimmed, filtered) and includes a trailing space
 // for convenient pasting into text fields.
 char *transcription_process(const float *audio_data, int n_samples, int sample_rate);
 
+// Cancellation token for a transcription, checked by whisper between graph steps so in-flight
+// inference stops within one step. Fires on transcription_cancel() or once the deadline passes.
+typedef struct {
+    bool cancelled;  // Atomic access required
+    double deadline; // utils_now() time to give up at, 0 for none
+} TranscriptionCancel;
+
+// timeout_ms <= 0 means no deadline
+void transcription_cancel_init(TranscriptionCancel *token, double timeout_ms);
+void transcription_cancel(TranscriptionCancel *token);
+bool transcription_is_cancelled(TranscriptionCancel *token);
+
+// Where the time of one transcription went. whisper's own stage timings only exist for a context's
+// built-in state, so these are measured at the stage boundaries: encode runs from the start of an
+// encoder pass to the first sampled token (prompt processing included), decode covers the rest.
+typedef struct {
+    double vad_ms;
+    double wait_ms;         // Waiting for a free whisper state
+    double mel_ms;
+    double encode_ms;
+    double decode_ms;       // Decoding and sampling
+    double postprocess_ms;
+    double total_ms;
+    int n_windows;          // Encoder passes, 0 if the clip was skipped before inference
+    int n_decode_passes;    // More than n_windows means temperature fallbacks
+    int n_sampled_tokens;   // Across all decoder passes
+    int n_output_tokens;    // In the returned segments
+} TranscriptionTimings;
+
+typedef struct {
+    char *text; // As returned by transcription_process(), NULL on error or cancel
+    TranscriptionTimings timings;
+} TranscriptionResult;
+
+// Settings for a single transcription_run, leaving the process-wide ones other transcriptions
+// use alone (the thread autotune runs while the user dictates)
+typedef struct {
+    int n_threads; // Threads for this transcription, 0 for the pool's choice
+    int vad;       // 0 or 1, -1 for the default (transcription_set_tuning, "vad_enabled" preference)
+} TranscriptionOptions;
+
+// Same as transcription_process, also reporting per-stage timings. Reuses the log-mel frames
+// computed while recording (see mel.h): audio_data must point into the recording the cache was
+// finished with, otherwise mel is ignored. mel, cancel and options may be NULL.
+struct MelCache;
+TranscriptionResult transcription_run(const float *audio_data, int n_samples, int sample_rate,
+                                      const struct MelCache *mel, TranscriptionCancel *cancel,
+                                      const TranscriptionOptions *options);
+
+// Totals over all transcriptions that ran inference to completion
+typedef struct {
+    int runs;
+    TranscriptionTimings sum;
+} TranscriptionTimingStats;
+
+void transcription_get_timing_stats(TranscriptionTimingStats *stats);
+
+// Clips short-circuited before inference because they can't contain speech
+typedef struct {
+    int inferences;        // Clips that ran whisper inference
+    int skipped_too_short; // Shorter than 100 ms
+    int skipped_silent;    // Below the energy threshold
+    int skipped_no_speech; // VAD found no speech segments
+    int cancelled;         // Stopped by a cancellation token
+} TranscriptionSkipStats;
+
+void transcription_get_skip_stats(TranscriptionSkipStats *stats);
+
+#define TRANSCRIPTION_MAX_STATES 8
+
+// whisper's API doesn't expose the size of its buffers, so memory is measured as process RSS
+// (utils_get_rss). This reports how many states, each with its own KV caches and compute buffers,
+// the loaded model holds.
+typedef struct {
+    int n_states;  // Pool slots
+    int n_created; // States allocated so far, slots are filled on demand
+} TranscriptionMemoryStats;
+
+void transcription_get_memory_stats(TranscriptionMemoryStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
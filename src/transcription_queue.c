@@ -0,0 +1,108 @@
+#include "transcription_queue.h"
+#include "logging.h"
+#include "utils.h"
+#include <stdlib.h>
+
+// A handful of slots is plenty, a job is one hotkey release
+#define QUEUE_CAPACITY 16
+#define QUEUE_POLL_MS 5
+
+typedef struct {
+    transcription_job_fn fn;
+    void *job;
+} QueueSlot;
+
+typedef struct {
+    // Single producer writes head, the worker writes tail; one slot stays empty to tell full from empty
+    QueueSlot slots[QUEUE_CAPACITY];
+    int head; // Atomic access required
+    int tail; // Atomic access required
+
+    utils_thread_t *thread;
+    bool running; // Atomic access required
+} TranscriptionQueue;
+
+// Global singleton instance
+static TranscriptionQueue *g_queue = NULL;
+
+// Run all queued jobs, returns how many ran
+static int run_pending_jobs(TranscriptionQueue *queue) {
+    int ran = 0;
+    int tail = utils_atomic_read_int(&queue->tail);
+    while (tail != utils_atomic_read_int(&queue->head)) {
+        QueueSlot slot = queue->slots[tail];
+        tail = (tail + 1) % QUEUE_CAPACITY;
+        utils_atomic_write_int(&queue->tail, tail);
+
+        slot.fn(slot.job);
+        ran++;
+    }
+    return ran;
+}
+
+static void *queue_worker(void *arg) {
+    TranscriptionQueue *queue = (TranscriptionQueue *) arg;
+
+    while (utils_atomic_read_bool(&queue->running)) {
+        if (run_pending_jobs(queue) == 0) {
+            utils_sleep_ms(QUEUE_POLL_MS);
+        }
+    }
+
+    // Don't drop a dictation that was released right before quitting
+    run_pending_jobs(queue);
+    return NULL;
+}
+
+bool transcription_queue_init(void) {
+    if (g_queue) {
+        return true;
+    }
+
+    g_queue = (TranscriptionQueue *) calloc(1, sizeof(TranscriptionQueue));
+    if (!g_queue) {
+        return false;
+    }
+
+    utils_atomic_write_bool(&g_queue->running, true);
+    g_queue->thread = utils_thread_create(queue_worker, g_queue);
+    if (!g_queue->thread) {
+        log_error("Failed to start transcription worker");
+        free(g_queue);
+        g_queue = NULL;
+        return false;
+    }
+
+    log_info("Transcription worker started");
+    return true;
+}
+
+bool transcription_queue_push(transcription_job_fn fn, void *job) {
+    if (!g_queue || !fn) {
+        return false;
+    }
+
+    int head = utils_atomic_read_int(&g_queue->head);
+    int next = (head + 1) % QUEUE_CAPACITY;
+    if (next == utils_atomic_read_int(&g_queue->tail)) {
+        log_error("Transcription queue is full, dropping job");
+        return false;
+    }
+
+    g_queue->slots[head].fn = fn;
+    g_queue->slots[head].job = job;
+    utils_atomic_write_int(&g_queue->head, next);
+    return true;
+}
+
+void transcription_queue_cleanup(void) {
+    if (!g_queue) {
+        return;
+    }
+
+    utils_atomic_write_bool(&g_queue->running, false);
+    utils_thread_join(g_queue->thread);
+
+    free(g_queue);
+    g_queue = NULL;
+}
@@ -0,0 +1,21 @@
+#ifndef TRANSCRIPTION_QUEUE_H
+#define TRANSCRIPTION_QUEUE_H
+
+#include <stdbool.h>
+
+// Dedicated transcription worker fed by a lock-free single-producer queue.
+// Jobs are pushed from the keylogger thread and run one at a time, in order, on the worker,
+// so key callbacks return immediately and a new recording can start while the last one is transcribed.
+typedef void (*transcription_job_fn)(void *job);
+
+// Start the worker thread
+bool transcription_queue_init(void);
+
+// Queue a job. Only call from one thread (the keylogger thread).
+// Returns false if the queue is full or not running; the caller still owns job then.
+bool transcription_queue_push(transcription_job_fn fn, void *job);
+
+// Run any queued jobs, then stop the worker
+void transcription_queue_cleanup(void);
+
+#endif // TRANSCRIPTION_QUEUE_H
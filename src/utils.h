@@ -39,6 +39,36 @@ FILE *utils_fopen_append(const char *path);
 char *utils_strdup(const char *str);
 int utils_stricmp(const char *s1, const char *s2);
 
+// Names of the files in dir ending in extension (case-insensitive), sorted. Returns the count and
+// stores a malloc'd array of malloc'd names in *names (free with utils_free_names), or -1 on error.
+int utils_list_dir(const char *dir, const char *extension, char ***names);
+void utils_free_names(char **names, int count);
+
+// Map a whole file read-only, the pages come from the OS file cache. Touching a page of a file that
+// was truncated after mapping raises SIGBUS, don't read maps of files that may change. Returns NULL
+// on error, unmap with utils_unmap_file.
+const void *utils_map_file(const char *path, size_t *size);
+void utils_unmap_file(const void *data, size_t size);
+// Read a file into the OS file cache so the next read doesn't wait for the disk. Blocks, call it
+// off the main thread. Stores the file size in *size, returns false if the file can't be read.
+bool utils_prefetch_file(const char *path, size_t *size);
+// Keep a memory range in RAM (mlock, VirtualLock). Returns false if the OS refuses, usually because
+// of the locked memory limit.
+bool utils_lock_memory(const void *data, size_t size);
+void utils_unlock_memory(const void *data, size_t size);
+
+// Peak resident set size of this process in bytes, 0 if unknown
+size_t utils_get_peak_rss(void);
+// Current resident set size of this process in bytes, 0 if unknown
+size_t utils_get_rss(void);
+// Open file descriptors (handles on Windows) of this process, -1 if unknown
+int utils_get_open_handle_count(void);
+
+// Logical processors available to this process, at least 1
+int utils_get_cpu_count(void);
+// Processor model name, empty if unknown
+const char *utils_get_cpu_name(void);
+
 // Atomic operations for thread-safe access to shared variables
 bool utils_atomic_read_bool(bool *ptr);
 void utils_atomic_write_bool(bool *ptr, bool value);
@@ -56,4 +86,11 @@ void utils_mutex_unlock(utils_mutex_t* mutex);
 // Cross-platform thread ID for debugging
 void* utils_thread_id(void);
 
+// Joinable thread API for long-lived workers (unlike utils_execute_async, no main thread callback)
+typedef struct utils_thread utils_thread_t;
+
+utils_thread_t* utils_thread_create(async_work_fn work, void* arg);
+// Wait for the thread to finish, free it and return the work function's result
+void* utils_thread_join(utils_thread_t* thread);
+
 #endif // UTILS_H
\ No newline at end of file
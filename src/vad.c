@@ -0,0 +1,201 @@
+#include "vad.h"
+#include "logging.h"
+#include "utils.h"
+#include "whisper.h"
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VAD_USE_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VAD_USE_NEON
+#endif
+
+#define ENERGY_FRAME_SAMPLES (WHISPER_SAMPLE_RATE / 50) // 20 ms
+#define TRIM_RMS_FLOOR 0.003f // Never treat frames louder than about -50 dBFS as silence
+#define TRIM_RMS_RATIO 0.05f  // Frames quieter than 5% of the loudest are silence
+
+static struct whisper_vad_context *g_vad_ctx = NULL;
+static utils_mutex_t *g_vad_mutex = NULL; // The VAD context keeps per-run state, one detection at a time
+
+void vad_setup(void) {
+    if (!g_vad_mutex) {
+        g_vad_mutex = utils_mutex_create();
+    }
+}
+
+int vad_init(const char *model_path) {
+    if (!model_path || !g_vad_mutex) {
+        return -1;
+    }
+
+    utils_mutex_lock(g_vad_mutex);
+    if (g_vad_ctx) {
+        utils_mutex_unlock(g_vad_mutex);
+        return 0;
+    }
+
+    double start = utils_now();
+    struct whisper_vad_context_params params = whisper_vad_default_context_params();
+    params.n_threads = 1; // Silero is tiny, more threads only add overhead
+    params.use_gpu = false;
+    g_vad_ctx = whisper_vad_init_from_file_with_params(model_path, params);
+    utils_mutex_unlock(g_vad_mutex);
+
+    if (!g_vad_ctx) {
+        log_error("ERROR: Failed to load VAD model: %s", model_path);
+        return -1;
+    }
+
+    log_info("🎙️ VAD model loaded (took %.0f ms)", (utils_now() - start) * 1000.0);
+    return 0;
+}
+
+void vad_cleanup(void) {
+    if (!g_vad_mutex) {
+        return;
+    }
+
+    utils_mutex_lock(g_vad_mutex);
+    if (g_vad_ctx) {
+        whisper_vad_free(g_vad_ctx);
+        g_vad_ctx = NULL;
+    }
+    utils_mutex_unlock(g_vad_mutex);
+}
+
+bool vad_is_loaded(void) {
+    if (!g_vad_mutex) {
+        return false;
+    }
+
+    utils_mutex_lock(g_vad_mutex);
+    bool loaded = g_vad_ctx != NULL;
+    utils_mutex_unlock(g_vad_mutex);
+    return loaded;
+}
+
+int vad_detect(const float *samples, int n_samples, VadSegment *segments, int max_segments) {
+    if (!g_vad_mutex || !samples || n_samples <= 0) {
+        return -1;
+    }
+
+    utils_mutex_lock(g_vad_mutex);
+    if (!g_vad_ctx) {
+        utils_mutex_unlock(g_vad_mutex);
+        return -1;
+    }
+
+    struct whisper_vad_params params = whisper_vad_default_params();
+    struct whisper_vad_segments *result = whisper_vad_segments_from_samples(g_vad_ctx, params, samples, n_samples);
+    if (!result) {
+        utils_mutex_unlock(g_vad_mutex);
+        log_error("ERROR: VAD detection failed");
+        return -1;
+    }
+
+    // Segment times are in centiseconds
+    int n_segments = whisper_vad_segments_n_segments(result);
+    for (int i = 0; i < n_segments && i < max_segments; i++) {
+        int start = (int) (whisper_vad_segments_get_segment_t0(result, i) * WHISPER_SAMPLE_RATE / 100.0f);
+        int end = (int) (whisper_vad_segments_get_segment_t1(result, i) * WHISPER_SAMPLE_RATE / 100.0f);
+        segments[i].start = start < 0 ? 0 : start;
+        segments[i].end = end > n_samples ? n_samples : end;
+    }
+
+    whisper_vad_free_segments(result);
+    utils_mutex_unlock(g_vad_mutex);
+    return n_segments;
+}
+
+bool vad_contains_speech(const float *samples, int n_samples) {
+    VadSegment segment;
+    return vad_detect(samples, n_samples, &segment, 1) != 0;
+}
+
+static float sum_of_squares(const float *samples, int count) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(VAD_USE_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(samples + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(VAD_USE_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(samples + i);
+        acc = vmlaq_f32(acc, v, v);
+    }
+    sum = vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) + vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#endif
+    for (; i < count; i++) {
+        sum += samples[i] * samples[i];
+    }
+    return sum;
+}
+
+float vad_peak_rms(const float *samples, int n_samples) {
+    if (!samples || n_samples <= 0) {
+        return 0.0f;
+    }
+
+    float peak = 0.0f;
+    for (int offset = 0; offset < n_samples; offset += ENERGY_FRAME_SAMPLES) {
+        int count = n_samples - offset < ENERGY_FRAME_SAMPLES ? n_samples - offset : ENERGY_FRAME_SAMPLES;
+        float energy = sum_of_squares(samples + offset, count) / (float) count;
+        if (energy > peak) {
+            peak = energy;
+        }
+    }
+    return sqrtf(peak);
+}
+
+int vad_trim_silence(const float *samples, int n_samples, int pad_ms, int *start) {
+    *start = 0;
+    if (!samples || n_samples <= 0) {
+        return n_samples;
+    }
+
+    float threshold = vad_peak_rms(samples, n_samples) * TRIM_RMS_RATIO;
+    if (threshold < TRIM_RMS_FLOOR) {
+        threshold = TRIM_RMS_FLOOR;
+    }
+    float threshold_energy = threshold * threshold;
+
+    int n_frames = (n_samples + ENERGY_FRAME_SAMPLES - 1) / ENERGY_FRAME_SAMPLES;
+    int first = -1;
+    int last = -1;
+    for (int i = 0; i < n_frames; i++) {
+        int offset = i * ENERGY_FRAME_SAMPLES;
+        int count = n_samples - offset < ENERGY_FRAME_SAMPLES ? n_samples - offset : ENERGY_FRAME_SAMPLES;
+        if (sum_of_squares(samples + offset, count) / (float) count >= threshold_energy) {
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+    if (first < 0) {
+        return n_samples;
+    }
+
+    int pad = pad_ms > 0 ? pad_ms * (WHISPER_SAMPLE_RATE / 1000) : 0;
+    int begin = first * ENERGY_FRAME_SAMPLES - pad;
+    int end = (last + 1) * ENERGY_FRAME_SAMPLES + pad;
+    if (begin < 0) {
+        begin = 0;
+    }
+    if (end > n_samples) {
+        end = n_samples;
+    }
+
+    *start = begin;
+    return end - begin;
+}
@@ -0,0 +1,37 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdbool.h>
+
+// Voice activity detection on a persistent Silero VAD context.
+// Loaded once by models_load() so transcriptions don't reload the VAD model on every call.
+
+// A speech segment in sample offsets, end is exclusive
+typedef struct {
+    int start;
+    int end;
+} VadSegment;
+
+// Create the lock guarding the VAD context. Call once from the main thread before any thread
+// loads or uses VAD, vad_init fails without it.
+void vad_setup(void);
+
+int vad_init(const char *model_path);
+void vad_cleanup(void);
+bool vad_is_loaded(void);
+
+// Detect speech segments in 16 kHz mono audio. Stores up to max_segments segments and
+// returns the total number found, or -1 if VAD isn't loaded or detection failed.
+int vad_detect(const float *samples, int n_samples, VadSegment *segments, int max_segments);
+
+// True if the buffer contains speech. Returns true when VAD isn't loaded so callers never drop audio.
+bool vad_contains_speech(const float *samples, int n_samples);
+
+// RMS of the loudest 20 ms frame, a cheap energy check that doesn't need the VAD model
+float vad_peak_rms(const float *samples, int n_samples);
+
+// Find the span between the first and last voiced 20 ms frame by energy, widened by pad_ms on
+// both sides. Stores the span start in *start and returns its length (n_samples if nothing is voiced).
+int vad_trim_silence(const float *samples, int n_samples, int pad_ms, int *start);
+
+#endif // VAD_H
@@ -0,0 +1,19 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <stdint.h>
+
+// Simple WAV file reader for the command line tools, mixes down to mono float samples
+typedef struct {
+    uint32_t sample_rate;
+    uint16_t channels;
+    uint16_t bits_per_sample;
+    uint32_t data_size;
+    float *samples;
+    int sample_count;
+} WavFile;
+
+// Read 16-bit PCM or 32-bit float WAV. Returns 0 on success, the caller frees wav->samples.
+int wav_read(const char *filename, WavFile *wav);
+
+#endif // WAV_H
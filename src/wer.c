@@ -0,0 +1,64 @@
+#include "wer.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <string.h>
+
+#define MAX_WORDS 4096
+
+// Split text into lowercase words, ignoring punctuation. Returns the word count, words point into buffer.
+static int split_words(const char *text, char *buffer, size_t buffer_size, char **words, int max_words) {
+    size_t len = 0;
+    for (const char *p = text; *p && len + 1 < buffer_size; p++) {
+        unsigned char c = (unsigned char) *p;
+        buffer[len++] = (char) (isalnum(c) || c == '\'' || c >= 0x80 ? tolower(c) : ' ');
+    }
+    buffer[len] = '\0';
+
+    int count = 0;
+    for (char *word = strtok(buffer, " "); word && count < max_words; word = strtok(NULL, " ")) {
+        words[count++] = word;
+    }
+    return count;
+}
+
+int word_errors(const char *reference, const char *hypothesis, int *n_reference) {
+    static char ref_buffer[65536], hyp_buffer[65536];
+    static char *ref_words[MAX_WORDS], *hyp_words[MAX_WORDS];
+    static int row[MAX_WORDS + 1];
+
+    int n_ref = split_words(reference, ref_buffer, sizeof(ref_buffer), ref_words, MAX_WORDS);
+    int n_hyp = split_words(hypothesis, hyp_buffer, sizeof(hyp_buffer), hyp_words, MAX_WORDS);
+    if (n_reference) {
+        *n_reference = n_ref;
+    }
+    if (n_ref == 0) {
+        return n_hyp;
+    }
+
+    for (int j = 0; j <= n_hyp; j++) {
+        row[j] = j;
+    }
+    for (int i = 1; i <= n_ref; i++) {
+        int diagonal = row[0];
+        row[0] = i;
+        for (int j = 1; j <= n_hyp; j++) {
+            int above = row[j];
+            int cost = strcmp(ref_words[i - 1], hyp_words[j - 1]) == 0 ? 0 : 1;
+            int best = diagonal + cost;
+            if (above + 1 < best) best = above + 1;
+            if (row[j - 1] + 1 < best) best = row[j - 1] + 1;
+            row[j] = best;
+            diagonal = above;
+        }
+    }
+    return row[n_hyp];
+}
+
+double word_error_rate(const char *reference, const char *hypothesis) {
+    int n_ref = 0;
+    int errors = word_errors(reference, hypothesis, &n_ref);
+    if (n_ref == 0) {
+        return errors == 0 ? 0.0 : 1.0;
+    }
+    return (double) errors / n_ref;
+}
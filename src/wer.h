@@ -0,0 +1,12 @@
+#ifndef WER_H
+#define WER_H
+
+// Word error rate: word-level edit distance divided by the number of reference words.
+// Case and punctuation are ignored. Not thread-safe, uses static buffers.
+double word_error_rate(const char *reference, const char *hypothesis);
+
+// Word-level edit distance, stores the number of reference words in n_reference (may be NULL).
+// Sum both over a corpus for its overall word error rate.
+int word_errors(const char *reference, const char *hypothesis, int *n_reference);
+
+#endif // WER_H
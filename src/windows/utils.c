@@ -4,7 +4,9 @@
 #include <process.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <windows.h>
+#include <psapi.h>
 
 // High-resolution timer frequency
 static LARGE_INTEGER g_frequency = {0};
@@ -497,3 +499,220 @@ void utils_mutex_unlock(utils_mutex_t* mutex) {
 void* utils_thread_id(void) {
     return (void*)(uintptr_t)GetCurrentThreadId();
 }
+
+// Joinable thread implementation using _beginthreadex
+struct utils_thread {
+    HANDLE handle;
+    async_work_fn work;
+    void* arg;
+    void* result;
+};
+
+static unsigned __stdcall utils_thread_proc(void *data) {
+    utils_thread_t* t = (utils_thread_t*) data;
+    t->result = t->work(t->arg);
+    return 0;
+}
+
+utils_thread_t* utils_thread_create(async_work_fn work, void* arg) {
+    utils_thread_t* t = calloc(1, sizeof(utils_thread_t));
+    if (!t) return NULL;
+
+    t->work = work;
+    t->arg = arg;
+    t->handle = (HANDLE) _beginthreadex(NULL, 0, utils_thread_proc, t, 0, NULL);
+    if (!t->handle) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void* utils_thread_join(utils_thread_t* thread) {
+    if (!thread) return NULL;
+
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    void* result = thread->result;
+    free(thread);
+    return result;
+}
+
+// Directory listing and memory usage
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+int utils_list_dir(const char *dir, const char *extension, char ***names) {
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*%s", dir, extension);
+
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA(pattern, &data);
+    if (handle == INVALID_HANDLE_VALUE) {
+        *names = NULL;
+        return GetLastError() == ERROR_FILE_NOT_FOUND ? 0 : -1;
+    }
+
+    int count = 0;
+    int capacity = 0;
+    char **list = NULL;
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            char **new_list = realloc(list, capacity * sizeof(char *));
+            if (!new_list) {
+                break;
+            }
+            list = new_list;
+        }
+        list[count] = utils_strdup(data.cFileName);
+        if (list[count]) {
+            count++;
+        }
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+
+    if (count > 0) {
+        qsort(list, count, sizeof(char *), compare_names);
+    }
+    *names = list;
+    return count;
+}
+
+void utils_free_names(char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+size_t utils_get_peak_rss(void) {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+const void *utils_map_file(const char *path, size_t *size) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return NULL;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // The view keeps the mapping alive
+    if (!data) {
+        return NULL;
+    }
+    *size = (size_t) file_size.QuadPart;
+    return data;
+}
+
+void utils_unmap_file(const void *data, size_t size) {
+    (void) size;
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+}
+
+bool utils_prefetch_file(const char *path, size_t *size) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // No read-ahead advice on Windows, a sequential read fills the cache just as well
+    char *buffer = malloc(1 << 20);
+    bool ok = buffer != NULL;
+    DWORD n = 0;
+    while (ok && ReadFile(file, buffer, 1 << 20, &n, NULL) && n > 0) {
+    }
+    free(buffer);
+    CloseHandle(file);
+    *size = (size_t) file_size.QuadPart;
+    return ok;
+}
+
+bool utils_lock_memory(const void *data, size_t size) {
+    if (!data) {
+        return false;
+    }
+    // Locked pages count against the working set minimum, grow it by what is locked
+    SIZE_T min_size = 0;
+    SIZE_T max_size = 0;
+    HANDLE process = GetCurrentProcess();
+    if (!GetProcessWorkingSetSize(process, &min_size, &max_size) ||
+        !SetProcessWorkingSetSize(process, min_size + size, max_size + size)) {
+        return false;
+    }
+    return VirtualLock((LPVOID) data, size) != 0;
+}
+
+void utils_unlock_memory(const void *data, size_t size) {
+    if (data) {
+        VirtualUnlock((LPVOID) data, size);
+    }
+}
+
+size_t utils_get_rss(void) {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+int utils_get_open_handle_count(void) {
+    DWORD count = 0;
+    if (!GetProcessHandleCount(GetCurrentProcess(), &count)) {
+        return -1;
+    }
+    return (int) count;
+}
+
+int utils_get_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+}
+
+const char *utils_get_cpu_name(void) {
+    static char name[256] = {0};
+    if (name[0] != '\0') {
+        return name;
+    }
+
+    HKEY hKey;
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", 0, KEY_READ,
+                      &hKey) == ERROR_SUCCESS) {
+        DWORD size = sizeof(name) - 1;
+        DWORD type;
+        if (RegQueryValueExA(hKey, "ProcessorNameString", NULL, &type, (LPBYTE) name, &size) != ERROR_SUCCESS ||
+            type != REG_SZ) {
+            name[0] = '\0';
+        }
+        RegCloseKey(hKey);
+    }
+    return name;
+}